@@ -4,8 +4,10 @@
 
 #include <bench/bench.h>
 
+#include <chainparams.h>
 #include <crypto/sha256.h>
 #include <key.h>
+#include <script/sigcache.h>
 #include <validation.h>
 #include <util.h>
 #include <random.h>
@@ -47,6 +49,8 @@ main(int argc, char** argv)
     ECC_Start();
     SetupEnvironment();
     fPrintToDebugLog = false; // don't want to write to debug.log file
+    SelectParams(CBaseChainParams::MAIN);
+    InitSignatureCache();
 
     int64_t evaluations = gArgs.GetArg("-evals", DEFAULT_BENCH_EVALUATIONS);
     std::string regex_filter = gArgs.GetArg("-filter", DEFAULT_BENCH_FILTER);
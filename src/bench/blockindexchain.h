@@ -0,0 +1,87 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PULSAR_BENCH_BLOCKINDEXCHAIN_H
+#define PULSAR_BENCH_BLOCKINDEXCHAIN_H
+
+#include <chain.h>
+#include <random.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validation.h>
+
+#include <deque>
+
+/**
+ * Block index entries without blocks behind them, for the benchmarks of code
+ * that walks the block tree. Entries keep their addresses as more are added,
+ * and may branch off any earlier entry.
+ */
+struct CBenchBlockIndexChain
+{
+    std::deque<uint256> vHashes;
+    std::deque<CBlockIndex> vBlocks;
+
+    CBenchBlockIndexChain() {}
+
+    /** A chain of nLength entries from height 0, with random hashes */
+    explicit CBenchBlockIndexChain(int nLength)
+    {
+        for (int i = 0; i < nLength; i++)
+            Add(Tip(), GetRandHash());
+    }
+
+    CBenchBlockIndexChain(const CBenchBlockIndexChain&) = delete;
+    CBenchBlockIndexChain& operator=(const CBenchBlockIndexChain&) = delete;
+
+    /** Add an entry on top of pprev, or a genesis for nullptr, linked through
+     *  pprev and the skip list. Fields the skip list does not depend on are
+     *  left to the caller. */
+    CBlockIndex& Add(CBlockIndex* pprev, const uint256& hash)
+    {
+        vHashes.push_back(hash);
+        vBlocks.emplace_back();
+        CBlockIndex& block = vBlocks.back();
+        block.phashBlock = &vHashes.back();
+        block.pprev = pprev;
+        block.nHeight = pprev ? pprev->nHeight + 1 : 0;
+        block.BuildSkip();
+        return block;
+    }
+
+    CBlockIndex* Tip() { return vBlocks.empty() ? nullptr : &vBlocks.back(); }
+    CBlockIndex& operator[](size_t i) { return vBlocks[i]; }
+    size_t size() const { return vBlocks.size(); }
+};
+
+/**
+ * Swaps the entries of a CBenchBlockIndexChain in for the contents of
+ * mapBlockIndex, for code that looks blocks up by hash, and the previous
+ * contents back on destruction.
+ */
+class CBenchBlockIndexMapScope
+{
+private:
+    BlockMap mapSaved;
+
+public:
+    explicit CBenchBlockIndexMapScope(CBenchBlockIndexChain& chain)
+    {
+        LOCK(cs_main);
+        mapBlockIndex.swap(mapSaved);
+        for (CBlockIndex& block : chain.vBlocks)
+            mapBlockIndex.emplace(block.GetBlockHash(), &block);
+    }
+
+    ~CBenchBlockIndexMapScope()
+    {
+        LOCK(cs_main);
+        mapBlockIndex.swap(mapSaved);
+    }
+
+    CBenchBlockIndexMapScope(const CBenchBlockIndexMapScope&) = delete;
+    CBenchBlockIndexMapScope& operator=(const CBenchBlockIndexMapScope&) = delete;
+};
+
+#endif // PULSAR_BENCH_BLOCKINDEXCHAIN_H
@@ -0,0 +1,93 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/blockindexchain.h>
+#include <bench/chainstate.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <miner.h>
+#include <random.h>
+#include <timedata.h>
+#include <txmempool.h>
+#include <validation.h>
+
+static const int MEMPOOL_TXS = 2000;
+
+// Active tip past the minotaurx fork and a mempool of independent transactions
+struct BlockTemplateSetup
+{
+    CBenchBlockIndexChain chain;
+    CBenchChainStateScope chainState;
+
+    BlockTemplateSetup() : chain(1)
+    {
+        CBlockIndex* pindexTip = chain.Tip();
+        pindexTip->nTime = GetAdjustedTime();
+        pindexTip->nBits = 0x1e0fffff;
+        pindexTip->SetBlockType();
+        {
+            LOCK(cs_main);
+            chainActive.SetTip(pindexTip);
+        }
+        for (int i = 0; i < MEMPOOL_TXS; i++) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+            tx.vin[0].scriptSig = CScript() << OP_1;
+            tx.vout.resize(1);
+            tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[0].nValue = COIN;
+            LockPoints lp;
+            mempool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(MakeTransactionRef(tx), 1000 + i, 0, 0, false, 4, lp));
+        }
+    }
+
+    ~BlockTemplateSetup()
+    {
+        mempool.clear();
+    }
+};
+
+// Select the transactions of a template from scratch, as on every new tip
+static void BlockTemplateCreate(benchmark::State& state)
+{
+    BlockTemplateSetup setup;
+    BlockTemplateCache cache;
+    LOCK(cs_main);
+    while (state.KeepRunning()) {
+        cache.Clear();
+        assert(cache.Get(Params(), POW_TYPE_CURVEHASH));
+    }
+}
+
+// A curvehash and a minotaurx template for the same tip: the second one reuses
+// the selection of the first, where it used to run CreateNewBlock again
+static void BlockTemplateCreateBothAlgos(benchmark::State& state)
+{
+    BlockTemplateSetup setup;
+    BlockTemplateCache cache;
+    LOCK(cs_main);
+    while (state.KeepRunning()) {
+        cache.Clear();
+        assert(cache.Get(Params(), POW_TYPE_CURVEHASH));
+        assert(cache.Get(Params(), POW_TYPE_MINOTAURX));
+    }
+}
+
+// Pool polling both algorithms alternately between tips
+static void BlockTemplatePollAlternating(benchmark::State& state)
+{
+    BlockTemplateSetup setup;
+    BlockTemplateCache cache;
+    LOCK(cs_main);
+    int i = 0;
+    while (state.KeepRunning()) {
+        assert(cache.Get(Params(), (i++ & 1) ? POW_TYPE_MINOTAURX : POW_TYPE_CURVEHASH));
+    }
+}
+
+BENCHMARK(BlockTemplateCreate, 20);
+BENCHMARK(BlockTemplateCreateBothAlgos, 10);
+BENCHMARK(BlockTemplatePollAlternating, 100000);
@@ -0,0 +1,56 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PULSAR_BENCH_CHAINSTATE_H
+#define PULSAR_BENCH_CHAINSTATE_H
+
+#include <chain.h>
+#include <coins.h>
+#include <sync.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <memory>
+
+/**
+ * Takes the active chain, the coins view, the block tree database and the
+ * index flags out of the global state, for a benchmark to set up its own,
+ * and puts the previous ones back on destruction.
+ */
+class CBenchChainStateScope
+{
+private:
+    CBlockIndex* pindexTipSaved;
+    std::unique_ptr<CCoinsViewCache> pcoinsTipSaved;
+    std::unique_ptr<CBlockTreeDB> pblocktreeSaved;
+    bool fTxIndexSaved;
+    bool fStakeIndexSaved;
+
+public:
+    CBenchChainStateScope()
+    {
+        LOCK(cs_main);
+        pindexTipSaved = chainActive.Tip();
+        chainActive.SetTip(nullptr);
+        pcoinsTipSaved = std::move(pcoinsTip);
+        pblocktreeSaved = std::move(pblocktree);
+        fTxIndexSaved = fTxIndex;
+        fStakeIndexSaved = fStakeIndex;
+    }
+
+    ~CBenchChainStateScope()
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(pindexTipSaved);
+        pcoinsTip = std::move(pcoinsTipSaved);
+        pblocktree = std::move(pblocktreeSaved);
+        fTxIndex = fTxIndexSaved;
+        fStakeIndex = fStakeIndexSaved;
+    }
+
+    CBenchChainStateScope(const CBenchChainStateScope&) = delete;
+    CBenchChainStateScope& operator=(const CBenchChainStateScope&) = delete;
+};
+
+#endif // PULSAR_BENCH_CHAINSTATE_H
@@ -0,0 +1,86 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/blockindexchain.h>
+#include <chain.h>
+#include <checkpointsync.h>
+#include <validation.h>
+
+static const int HEADERS_COUNT = 100000;
+static const int SYNC_CHECKPOINT_HEIGHT = 1000;
+
+// Chain of HEADERS_COUNT headers as the block index, with the sync-checkpoint near its start
+struct SyncCheckpointSetup
+{
+    CBenchBlockIndexChain chain;
+    CBenchBlockIndexMapScope mapScope;
+    uint256 hashSyncCheckpointOld;
+
+    SyncCheckpointSetup() : chain(HEADERS_COUNT), mapScope(chain)
+    {
+        AssertLockHeld(cs_main);
+        hashSyncCheckpointOld = hashSyncCheckpoint;
+        hashSyncCheckpoint = chain.vHashes[SYNC_CHECKPOINT_HEIGHT];
+    }
+
+    ~SyncCheckpointSetup()
+    {
+        hashSyncCheckpoint = hashSyncCheckpointOld;
+    }
+
+    void ClearCache()
+    {
+        for (CBlockIndex& block : chain.vBlocks)
+            block.pindexSyncCheckpoint = nullptr;
+    }
+};
+
+// Accept HEADERS_COUNT headers in order with sync-checkpoint enforcement, as headers-first sync does
+static void SyncCheckpointAcceptHeaders(benchmark::State& state)
+{
+    LOCK(cs_main);
+    SyncCheckpointSetup setup;
+    while (state.KeepRunning()) {
+        setup.ClearCache();
+        for (int i = 1; i < HEADERS_COUNT; i++)
+            assert(CheckSyncCheckpoint(setup.chain.vHashes[i], &setup.chain[i - 1]));
+    }
+}
+
+// Same, without the cached descendant-of-checkpoint flag: one skip list lookup per header
+static void SyncCheckpointAcceptHeadersNoCache(benchmark::State& state)
+{
+    LOCK(cs_main);
+    SyncCheckpointSetup setup;
+    while (state.KeepRunning()) {
+        for (int i = 1; i < HEADERS_COUNT; i++) {
+            setup.chain[i - 1].pindexSyncCheckpoint = nullptr;
+            if (i > 1)
+                setup.chain[i - 2].pindexSyncCheckpoint = nullptr;
+            assert(CheckSyncCheckpoint(setup.chain.vHashes[i], &setup.chain[i - 1]));
+        }
+    }
+}
+
+// The ancestry test as it was done before, walking pprev back to the checkpoint
+// height. Only every 100th header is checked, as the full run is quadratic.
+static void SyncCheckpointAcceptHeadersWalk(benchmark::State& state)
+{
+    LOCK(cs_main);
+    SyncCheckpointSetup setup;
+    const CBlockIndex* pindexSync = &setup.chain[SYNC_CHECKPOINT_HEIGHT];
+    while (state.KeepRunning()) {
+        for (int i = SYNC_CHECKPOINT_HEIGHT + 1; i < HEADERS_COUNT; i += 100) {
+            const CBlockIndex* pindex = &setup.chain[i - 1];
+            while (pindex->nHeight > pindexSync->nHeight)
+                pindex = pindex->pprev;
+            assert(pindex == pindexSync);
+        }
+    }
+}
+
+BENCHMARK(SyncCheckpointAcceptHeaders, 5);
+BENCHMARK(SyncCheckpointAcceptHeadersNoCache, 5);
+BENCHMARK(SyncCheckpointAcceptHeadersWalk, 5);
@@ -0,0 +1,138 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/blockindexchain.h>
+#include <bench/chainstate.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <key.h>
+#include <random.h>
+#include <script/standard.h>
+#include <validation.h>
+#include <wallet/wallet.h>
+
+#include <vector>
+
+static const int STAKE_CHAIN_LENGTH = 1000;
+static const int WALLET_COINS = 10000;
+static const CAmount WALLET_COIN_VALUE = COIN;
+// Inputs of the largest coinstake CreateCoinStake builds
+static const int COINSTAKE_MAX_INPUTS = 100;
+static const int64_t STAKE_SEARCH_INTERVAL = 16;
+// No kernel is expected to meet this target
+static const unsigned int STAKE_BITS_HARD = 0x1a00ffff;
+// Weighted by WALLET_COIN_VALUE, a target met by any hash
+static const unsigned int STAKE_BITS_ANY_HASH = 0x207fffff;
+
+// Active chain of interleaved PoS, CurveHash and MinotaurX blocks, and a wallet
+// holding WALLET_COINS confirmed outputs to one key in its first half, which
+// are in the coins view as well
+struct StakingWalletSetup
+{
+    CBenchBlockIndexChain chain;
+    CBenchBlockIndexMapScope mapScope;
+    CCoinsView viewDummy;
+    CBenchChainStateScope chainState;
+    CWallet wallet;
+    std::vector<COutPoint> vCoins;
+
+    StakingWalletSetup() : chain(STAKE_CHAIN_LENGTH), mapScope(chain)
+    {
+        const uint32_t nTimeStart = Params().GetConsensus().powForkTime;
+        LOCK2(cs_main, wallet.cs_wallet);
+        for (int i = 0; i < STAKE_CHAIN_LENGTH; i++) {
+            chain[i].nTime = nTimeStart + (i + 1) * 75;
+            chain[i].nBits = 0x1e00ffff;
+            chain[i].nPOWBlockHeight = i;
+            chain[i].bnStakeModifier = GetRandHash();
+            switch (i % 3) {
+            case 0: chain[i].SetProofOfStake(); break;
+            case 1: chain[i].nVersion = POW_TYPE_CURVEHASH << 16; break;
+            case 2: chain[i].nVersion = POW_TYPE_MINOTAURX << 16; break;
+            }
+            chain[i].SetBlockType();
+            chain[i].BuildPrevSameType();
+        }
+        chainActive.SetTip(chain.Tip());
+        pcoinsTip.reset(new CCoinsViewCache(&viewDummy));
+        fTxIndex = true;
+
+        CKey key;
+        key.MakeNewKey(true);
+        assert(wallet.LoadKey(key, key.GetPubKey()));
+        const CScript scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+        for (int i = 0; i < WALLET_COINS; i++) {
+            const CBlockIndex* pindex = &chain[1 + i % (STAKE_CHAIN_LENGTH / 2)];
+            CMutableTransaction tx;
+            tx.nTime = pindex->nTime;
+            tx.vin.emplace_back(GetRandHash(), 0);
+            tx.vout.emplace_back(WALLET_COIN_VALUE, scriptPubKey);
+            CWalletTx wtx(&wallet, MakeTransactionRef(std::move(tx)));
+            wtx.hashBlock = pindex->GetBlockHash();
+            wtx.nIndex = 1;
+            assert(wallet.LoadToWallet(wtx));
+
+            COutPoint outpoint(wtx.GetHash(), 0);
+            pcoinsTip->AddCoin(outpoint, Coin(wtx.tx->vout[0], pindex->nHeight, false, false, wtx.tx->nTime), false);
+            vCoins.push_back(outpoint);
+        }
+        wallet.LoadStakeCandidates();
+    }
+};
+
+// Coin age of coinstakes spending COINSTAKE_MAX_INPUTS wallet coins each, through a cache on the coins view
+static void CoinAge(benchmark::State& state)
+{
+    StakingWalletSetup setup;
+    LOCK(cs_main);
+    std::vector<CTransactionRef> vCoinStakes;
+    for (int i = 0; i < WALLET_COINS; i += COINSTAKE_MAX_INPUTS) {
+        CMutableTransaction tx;
+        tx.nTime = chainActive.Tip()->nTime;
+        for (int j = i; j < i + COINSTAKE_MAX_INPUTS; j++)
+            tx.vin.emplace_back(setup.vCoins[j]);
+        tx.vout.resize(2);
+        tx.vout[0].SetEmpty();
+        tx.vout[1] = CTxOut(COINSTAKE_MAX_INPUTS * WALLET_COIN_VALUE, CScript() << OP_TRUE);
+        vCoinStakes.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(pcoinsTip.get());
+        uint64_t nCoinAge;
+        assert(GetCoinAge(*vCoinStakes[i], view, chainActive.Tip(), nCoinAge));
+        assert(nCoinAge > 0);
+        if (++i == vCoinStakes.size())
+            i = 0;
+    }
+}
+
+// Kernel search over all wallet coins that finds nothing, as on most staking rounds
+static void CreateCoinStakeSearch(benchmark::State& state)
+{
+    StakingWalletSetup setup;
+    while (state.KeepRunning()) {
+        CMutableTransaction txCoinStake;
+        txCoinStake.nTime = chainActive.Tip()->nTime + STAKE_SEARCH_INTERVAL;
+        assert(!setup.wallet.CreateCoinStake(setup.wallet, STAKE_BITS_HARD, STAKE_SEARCH_INTERVAL, txCoinStake));
+    }
+}
+
+// A found kernel, combined with other wallet coins up to the combine threshold, rewarded and signed
+static void CreateCoinStakeFound(benchmark::State& state)
+{
+    StakingWalletSetup setup;
+    while (state.KeepRunning()) {
+        CMutableTransaction txCoinStake;
+        txCoinStake.nTime = chainActive.Tip()->nTime + STAKE_SEARCH_INTERVAL;
+        assert(setup.wallet.CreateCoinStake(setup.wallet, STAKE_BITS_ANY_HASH, STAKE_SEARCH_INTERVAL, txCoinStake));
+    }
+}
+
+BENCHMARK(CoinAge, 2000);
+BENCHMARK(CreateCoinStakeSearch, 10);
+BENCHMARK(CreateCoinStakeFound, 20);
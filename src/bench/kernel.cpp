@@ -0,0 +1,143 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/blockindexchain.h>
+#include <bench/chainstate.h>
+#include <amount.h>
+#include <arith_uint256.h>
+#include <chain.h>
+#include <consensus/validation.h>
+#include <hash.h>
+#include <kernel.h>
+#include <random.h>
+#include <streams.h>
+#include <txdb.h>
+#include <uint256.h>
+#include <validation.h>
+#include <bignum.h>
+
+static const unsigned int KERNEL_BITS = 0x1d00ffff;
+// Weighted by KERNEL_VALUE, a target met by any hash
+static const unsigned int KERNEL_BITS_ANY_HASH = 0x207fffff;
+static const CAmount KERNEL_VALUE = 1234 * COIN;
+static const int STAKE_INDEX_SIZE = 10000;
+
+// Kernel check as done with CBigNum and CDataStream before
+static void StakeKernelBigNum(benchmark::State& state)
+{
+    uint256 bnStakeModifier = uint256S("0x5f1a7c3e9b2d4f6a8c0e1d3b5a7f9c2e4d6b8a0f1e3c5d7b9a2f4e6c8d0b1a3c");
+    COutPoint prevout(uint256S("0x2a4c6e8f0b1d3f5a7c9e1b3d5f7a9c2e4b6d8f0a1c3e5b7d9f2a4c6e8b0d1f3a"), 1);
+    unsigned int nTimeTxPrev = 1650000000;
+    unsigned int nTimeTx = 1660000000;
+    bool fPass = false;
+    while (state.KeepRunning()) {
+        CBigNum bnTarget;
+        bnTarget.SetCompact(KERNEL_BITS);
+        bnTarget *= CBigNum(KERNEL_VALUE);
+
+        CDataStream ss(SER_GETHASH, 0);
+        ss << bnStakeModifier;
+        ss << nTimeTxPrev << prevout.hash << prevout.n << nTimeTx++;
+        fPass ^= !(CBigNum(Hash(ss.begin(), ss.end())) > bnTarget);
+    }
+}
+
+static void StakeKernel(benchmark::State& state)
+{
+    uint256 bnStakeModifier = uint256S("0x5f1a7c3e9b2d4f6a8c0e1d3b5a7f9c2e4d6b8a0f1e3c5d7b9a2f4e6c8d0b1a3c");
+    COutPoint prevout(uint256S("0x2a4c6e8f0b1d3f5a7c9e1b3d5f7a9c2e4b6d8f0a1c3e5b7d9f2a4c6e8b0d1f3a"), 1);
+    unsigned int nTimeTxPrev = 1650000000;
+    unsigned int nTimeTx = 1660000000;
+    bool fPass = false;
+    while (state.KeepRunning()) {
+        arith_uint256 bnTarget;
+        bool fAnyHash;
+        GetStakeKernelTarget(KERNEL_BITS, KERNEL_VALUE, bnTarget, fAnyHash);
+        fPass ^= fAnyHash || UintToArith256(GetStakeKernelHash(bnStakeModifier, nTimeTxPrev, prevout, nTimeTx++)) <= bnTarget;
+    }
+}
+
+static void CheckStakeKernel(benchmark::State& state)
+{
+    CBlockIndex indexPrev;
+    indexPrev.bnStakeModifier = uint256S("0x5f1a7c3e9b2d4f6a8c0e1d3b5a7f9c2e4d6b8a0f1e3c5d7b9a2f4e6c8d0b1a3c");
+    COutPoint prevout(uint256S("0x2a4c6e8f0b1d3f5a7c9e1b3d5f7a9c2e4b6d8f0a1c3e5b7d9f2a4c6e8b0d1f3a"), 1);
+    unsigned int nTimeBlockFrom = 1650000000;
+    unsigned int nTimeTx = 1660000000;
+    uint256 hashProofOfStake, targetProofOfStake;
+    bool fPass = false;
+    while (state.KeepRunning())
+        fPass ^= CheckStakeKernelHash(KERNEL_BITS, &indexPrev, nTimeBlockFrom, nTimeBlockFrom, KERNEL_VALUE, prevout, nTimeTx++, hashProofOfStake, targetProofOfStake);
+}
+
+// Coinstake checks without the signature, their kernels looked up in an
+// in-memory stake index of STAKE_INDEX_SIZE outputs, one per block of the
+// active chain
+static void CheckProofOfStakeIndexed(benchmark::State& state)
+{
+    CBenchBlockIndexChain chain(STAKE_INDEX_SIZE);
+    CBenchChainStateScope chainState;
+    LOCK(cs_main);
+    chain.Tip()->bnStakeModifier = GetRandHash();
+    chainActive.SetTip(chain.Tip());
+    pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+    fStakeIndex = true;
+
+    std::vector<std::pair<COutPoint, CStakePrevout> > vPrevouts;
+    std::vector<CTransactionRef> vCoinStakes;
+    for (int i = 0; i < STAKE_INDEX_SIZE; i++) {
+        COutPoint prevout(GetRandHash(), i % 3);
+        vPrevouts.emplace_back(prevout, CStakePrevout(CTxOut(KERNEL_VALUE, CScript() << OP_TRUE), 1650000000 + i, i, chain[i].GetBlockHash()));
+
+        CMutableTransaction tx;
+        tx.nTime = 1660000000 + i;
+        tx.vin.emplace_back(prevout);
+        tx.vout.resize(2);
+        tx.vout[0].SetEmpty();
+        tx.vout[1] = CTxOut(KERNEL_VALUE, CScript() << OP_TRUE);
+        vCoinStakes.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    assert(pblocktree->WriteStakeIndex(vPrevouts));
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        CValidationState validationState;
+        uint256 hashProofOfStake, targetProofOfStake;
+        assert(CheckProofOfStake(validationState, chain.Tip(), vCoinStakes[i], KERNEL_BITS_ANY_HASH, hashProofOfStake, targetProofOfStake, false));
+        if (++i == vCoinStakes.size())
+            i = 0;
+    }
+}
+
+// Depth check of a kernel block nDepth blocks below the tip, against a minimum of nDepth + 1 confirmations
+static void StakeKernelDepth(benchmark::State& state, int nDepth)
+{
+    CBenchBlockIndexChain chain(nDepth + 1);
+    CBenchBlockIndexMapScope mapScope(chain);
+    LOCK(cs_main);
+
+    int nActualDepth;
+    bool fConfirmed = true;
+    while (state.KeepRunning())
+        fConfirmed &= IsConfirmedInNPrevBlocks(chain.vHashes[0], chain.Tip(), nDepth + 1, nActualDepth);
+    assert(fConfirmed);
+}
+
+static void StakeKernelDepth100(benchmark::State& state)
+{
+    StakeKernelDepth(state, 100);
+}
+
+static void StakeKernelDepth10000(benchmark::State& state)
+{
+    StakeKernelDepth(state, 10000);
+}
+
+BENCHMARK(StakeKernelBigNum, 400 * 1000);
+BENCHMARK(StakeKernel, 2 * 1000 * 1000);
+BENCHMARK(CheckStakeKernel, 1000 * 1000);
+BENCHMARK(CheckProofOfStakeIndexed, 50 * 1000);
+BENCHMARK(StakeKernelDepth100, 5 * 1000 * 1000);
+BENCHMARK(StakeKernelDepth10000, 5 * 1000 * 1000);
@@ -0,0 +1,96 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/blockindexchain.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <pow.h>
+#include <primitives/block.h>
+
+static const int CHAIN_LENGTH = 30000;
+static const int MATCHING_BLOCKS = 1000;
+
+// Interleaved PoS, CurveHash and MinotaurX block types along chain, after the MinotaurX fork of the main network
+static void BuildMixedChain(CBenchBlockIndexChain& chain)
+{
+    const uint32_t nTimeMinotaurXFork = 1668211200;
+    for (int i = 0; i < CHAIN_LENGTH; i++) {
+        chain[i].nTime = nTimeMinotaurXFork + (i + 1) * 60;
+        chain[i].nBits = 0x1e00ffff - (i % 97) * 0x100;
+        switch (i % 3) {
+        case 0: chain[i].SetProofOfStake(); break;
+        case 1: chain[i].nVersion = POW_TYPE_CURVEHASH << 16; break;
+        case 2: chain[i].nVersion = POW_TYPE_MINOTAURX << 16; break;
+        }
+        chain[i].SetBlockType();
+        chain[i].BuildPrevSameType();
+    }
+}
+
+// Find the last MATCHING_BLOCKS MinotaurX blocks, classifying every block through a header copy
+static void LastBlocksForAlgoHeader(benchmark::State& state)
+{
+    CBenchBlockIndexChain chain(CHAIN_LENGTH);
+    BuildMixedChain(chain);
+    while (state.KeepRunning()) {
+        int nCount = 0;
+        for (const CBlockIndex* pindex = chain.Tip(); pindex && nCount < MATCHING_BLOCKS; pindex = pindex->pprev) {
+            if (!pindex->IsProofOfStake() && pindex->GetBlockHeader().GetPoWType() == POW_TYPE_MINOTAURX)
+                nCount++;
+        }
+        assert(nCount == MATCHING_BLOCKS);
+    }
+}
+
+// Same, using the cached block type
+static void LastBlocksForAlgo(benchmark::State& state)
+{
+    CBenchBlockIndexChain chain(CHAIN_LENGTH);
+    BuildMixedChain(chain);
+    while (state.KeepRunning()) {
+        int nCount = 0;
+        for (const CBlockIndex* pindex = chain.Tip(); pindex && nCount < MATCHING_BLOCKS; pindex = pindex->pprev) {
+            if (pindex->IsSameType(false, POW_TYPE_MINOTAURX))
+                nCount++;
+        }
+        assert(nCount == MATCHING_BLOCKS);
+    }
+}
+
+// Same, following the same type predecessor pointers
+static void LastBlocksForAlgoSameType(benchmark::State& state)
+{
+    CBenchBlockIndexChain chain(CHAIN_LENGTH);
+    BuildMixedChain(chain);
+    while (state.KeepRunning()) {
+        int nCount = 0;
+        for (const CBlockIndex* pindex = chain.Tip(); pindex && nCount < MATCHING_BLOCKS; pindex = pindex->pprevSameType)
+            nCount++;
+        assert(nCount == MATCHING_BLOCKS);
+    }
+}
+
+// Next targets of all three block types after the tip, through DarkGravityWave
+static void DarkGravityWaveMixed(benchmark::State& state)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    CBenchBlockIndexChain chain(CHAIN_LENGTH);
+    BuildMixedChain(chain);
+    int nTip = CHAIN_LENGTH - 1;
+    while (state.KeepRunning()) {
+        const CBlockIndex* pindexLast = &chain[nTip];
+        GetNextTargetRequired(pindexLast, true, params, POW_TYPE_CURVEHASH);
+        GetNextTargetRequired(pindexLast, false, params, POW_TYPE_CURVEHASH);
+        GetNextTargetRequired(pindexLast, false, params, POW_TYPE_MINOTAURX);
+        if (--nTip < CHAIN_LENGTH / 2)
+            nTip = CHAIN_LENGTH - 1;
+    }
+}
+
+BENCHMARK(LastBlocksForAlgoHeader, 500);
+BENCHMARK(LastBlocksForAlgo, 500);
+BENCHMARK(LastBlocksForAlgoSameType, 500);
+BENCHMARK(DarkGravityWaveMixed, 100 * 1000);
@@ -0,0 +1,218 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <amount.h>
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <crypto/minotaurx/minotaur.h>
+#include <key.h>
+#include <minotaurx.h>
+#include <pulsar.h>
+#include <script/interpreter.h>
+#include <streams.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+#include <version.h>
+
+namespace block_bench {
+#include <bench/data/pulsar_genesis.raw.h>
+} // namespace block_bench
+
+// Transactions of the proof-of-stake block fixture besides its coinbase and coinstake
+static const int POS_BLOCK_TXS = 200;
+
+// The main network genesis block, as the fixture for the proof-of-work hashes
+static CBlock ReadPulsarBlock()
+{
+    CDataStream stream((const char*)block_bench::pulsar_genesis,
+            (const char*)&block_bench::pulsar_genesis[sizeof(block_bench::pulsar_genesis)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    assert(block.GetHash() == chainParams->GetConsensus().hashGenesisBlock);
+    return block;
+}
+
+static void DeserializePulsarBlock(benchmark::State& state)
+{
+    CDataStream stream((const char*)block_bench::pulsar_genesis,
+            (const char*)&block_bench::pulsar_genesis[sizeof(block_bench::pulsar_genesis)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    while (state.KeepRunning()) {
+        CBlock block;
+        stream >> block;
+        assert(BlockMerkleRoot(block) == block.hashMerkleRoot);
+        assert(stream.Rewind(sizeof(block_bench::pulsar_genesis)));
+    }
+}
+
+static void SignPulsarInput(const CKey& key, const CScript& scriptPubKey, CMutableTransaction& tx)
+{
+    std::vector<unsigned char> vchSig;
+    const uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    assert(key.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    tx.vin[0].scriptSig = CScript() << vchSig;
+}
+
+// A proof-of-stake block with a chain of POS_BLOCK_TXS pay-to-pubkey spends,
+// built and signed with a fixed key, so it is the same block on every run, as
+// the fixture for the proof-of-stake block checks
+static CBlock CreatePulsarPoSBlock()
+{
+    CKey key;
+    const uint256 secret = uint256S("0x3c9a1f0e7b5d2c4a6e8f1b3d5c7a9e0f2b4d6c8a1e3f5b7d9c0a2e4f6b8d1c3a");
+    key.Set(secret.begin(), secret.end(), true);
+    assert(key.IsValid());
+    // The coinstake pays to the key that signs the block
+    const CScript scriptPubKey = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+    const uint32_t nTime = Params().GetConsensus().powForkTime + 3600;
+
+    CBlock block;
+    block.nVersion = CBlockHeader::CURRENT_VERSION;
+    block.hashPrevBlock = uint256S("0x00000000a7c3e1f5b9d2c4e6f8a0b1d3c5e7f9a2b4d6c8e0f1a3b5c7d9e2f4a6");
+    block.nTime = nTime;
+    block.nBits = 0x1d00ffff;
+
+    CMutableTransaction coinbase;
+    coinbase.nTime = nTime;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vin[0].scriptSig = CScript() << 500000 << OP_0;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].SetEmpty();
+    block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+
+    CMutableTransaction coinstake;
+    coinstake.nTime = nTime;
+    coinstake.vin.emplace_back(uint256S("0x6e2b8d4f0a1c3e5b7d9f2a4c6e8b0d1f3a5c7e9b2d4f6a8c0e1b3d5f7a9c2e4b"), 1);
+    coinstake.vout.resize(2);
+    coinstake.vout[0].SetEmpty();
+    coinstake.vout[1] = CTxOut(1000 * COIN, scriptPubKey);
+    SignPulsarInput(key, scriptPubKey, coinstake);
+    block.vtx.push_back(MakeTransactionRef(std::move(coinstake)));
+
+    for (int i = 0; i < POS_BLOCK_TXS; i++) {
+        CMutableTransaction tx;
+        tx.nTime = nTime - POS_BLOCK_TXS + i;
+        if (i)
+            tx.vin.emplace_back(block.vtx.back()->GetHash(), 0);
+        else
+            tx.vin.emplace_back(uint256S("0x1d3f5b7a9c2e4d6f8b0a1c3e5d7f9b2a4c6e8d0f1b3a5c7e9d2f4b6a8c0e1d3f"), 0);
+        tx.vout.emplace_back(1000 * COIN - (i + 1) * CENT, scriptPubKey);
+        SignPulsarInput(key, scriptPubKey, tx);
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    assert(key.Sign(block.GetHash(), block.vchBlockSig));
+    return block;
+}
+
+static void DeserializePulsarPoSBlock(benchmark::State& state)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << CreatePulsarPoSBlock();
+    const size_t nSize = stream.size();
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    while (state.KeepRunning()) {
+        CBlock block;
+        stream >> block;
+        assert(stream.Rewind(nSize));
+    }
+}
+
+// Context-free checks of a proof-of-stake block off the wire. The block
+// signature is verified on its own, since CheckBlock() leaves it in the
+// signature cache and every later run would only look it up.
+static void DeserializeAndCheckPulsarPoSBlock(benchmark::State& state)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << CreatePulsarPoSBlock();
+    const size_t nSize = stream.size();
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    while (state.KeepRunning()) {
+        CBlock block; // CBlock caches its checked state, so it is recreated here
+        stream >> block;
+        assert(stream.Rewind(nSize));
+
+        CValidationState validationState;
+        assert(CheckBlock(block, validationState, consensusParams, true, true, false));
+        assert(CheckBlockSignature(block));
+    }
+}
+
+// One CurveHash through Pulsar(), as block validation does
+static void PulsarCurveHash(benchmark::State& state)
+{
+    CBlockHeader header = ReadPulsarBlock().GetBlockHeader();
+    uint32_t nNonce = header.nNonce;
+    uint256 hash;
+    while (state.KeepRunning())
+        Pulsar(&header, nNonce++, &hash);
+}
+
+// CurveHashes of consecutive nonces in batches, as the miner scans them
+static void PulsarCurveHashScan(benchmark::State& state)
+{
+    CBlockHeader header = ReadPulsarBlock().GetBlockHeader();
+    CCurveHashEngine& engine = GetCurveHashEngine();
+    engine.SetScanHeader(header);
+    uint32_t nNonce = header.nNonce;
+    uint256 hashes[CCurveHashEngine::SCAN_BATCH_SIZE];
+    while (state.KeepRunning()) {
+        engine.ScanNonces(nNonce, CCurveHashEngine::SCAN_BATCH_SIZE, hashes);
+        nNonce += CCurveHashEngine::SCAN_BATCH_SIZE;
+    }
+}
+
+// MinotaurX, with the yespower gate
+static void MinotaurXHash(benchmark::State& state)
+{
+    CBlockHeader header = ReadPulsarBlock().GetBlockHeader();
+    header.nVersion = POW_TYPE_MINOTAURX << 16;
+    CMinotaurXHasher& hasher = GetMinotaurXHasher();
+    while (state.KeepRunning()) {
+        hasher.Hash(BEGIN(header.nVersion), END(header.nNonce));
+        header.nNonce++;
+    }
+}
+
+// Plain Minotaur, without the yespower gate. It never reaches yespower, so it
+// needs no arena and runs the primitive on a garden of its own.
+static uint256 MinotaurHeaderHash(const CBlockHeader& header, TortureGarden* garden)
+{
+    return Minotaur(BEGIN(header.nVersion), END(header.nNonce), false, nullptr, garden);
+}
+
+static void MinotaurHash(benchmark::State& state)
+{
+    CBlockHeader header = ReadPulsarBlock().GetBlockHeader();
+    header.nVersion = POW_TYPE_MINOTAURX << 16;
+    TortureGarden garden;
+    PlantTortureGarden(&garden);
+    while (state.KeepRunning()) {
+        MinotaurHeaderHash(header, &garden);
+        header.nNonce++;
+    }
+}
+
+BENCHMARK(DeserializePulsarBlock, 100 * 1000);
+BENCHMARK(DeserializePulsarPoSBlock, 1000);
+BENCHMARK(DeserializeAndCheckPulsarPoSBlock, 200);
+BENCHMARK(PulsarCurveHash, 2000);
+BENCHMARK(PulsarCurveHashScan, 250);
+BENCHMARK(MinotaurXHash, 200);
+BENCHMARK(MinotaurHash, 20 * 1000);
@@ -124,6 +124,16 @@ void CBlockIndex::BuildSkip()
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
 }
 
+void CBlockIndex::BuildPrevSameType()
+{
+    // Blocks of each type are interleaved, so this is a short walk
+    const bool fProofOfStake = IsProofOfStake();
+    const POW_TYPE powType = GetPoWType();
+    pprevSameType = pprev;
+    while (pprevSameType && !pprevSameType->IsSameType(fProofOfStake, powType))
+        pprevSameType = pprevSameType->pprev;
+}
+
 arith_uint256 GetBlockProof(const CBlockIndex& block, POW_TYPE powType)
 {
     arith_uint256 bnTarget;
@@ -135,7 +145,7 @@ arith_uint256 GetBlockProof(const CBlockIndex& block, POW_TYPE powType)
         return 0;
 
     // skip the wrong pow type
-    if (IsMinoEnabled(&block, Params().GetConsensus()) && block.GetBlockHeader().GetPoWType() != powType)
+    if (IsMinoEnabled(&block, Params().GetConsensus()) && block.GetPoWType() != powType)
         return 0;
     //  if you ask for MINO hashes before it's enabled, there aren't any!
     if (!IsMinoEnabled(&block, Params().GetConsensus()) && powType == POW_TYPE_MINOTAURX) 
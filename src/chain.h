@@ -181,6 +181,14 @@ public:
     //! pointer to the index of some further predecessor of this block
     CBlockIndex* pskip;
 
+    //! pulsar: pointer to the index of the nearest predecessor of the same
+    //! type (proof-of-stake, or proof-of-work with the same PoW type)
+    CBlockIndex* pprevSameType;
+
+    //! pulsar: (memory only) sync-checkpoint this block was last found to
+    //! descend from, see IsDescendantOfSyncCheckpoint()
+    mutable const CBlockIndex* pindexSyncCheckpoint;
+
     //! height of the entry in the chain. The genesis block has height 0
     int nHeight;
 
@@ -228,6 +236,7 @@ public:
 
     // pulsar: proof-of-stake related block index fields
     unsigned int nFlags;  // pulsar: block index flags
+    uint16_t nBlockType;  // pulsar: (memory only) proof-of-stake flag and PoW type, see SetBlockType()
     enum
     {
         BLOCK_PROOF_OF_STAKE = (1 << 0), // is proof-of-stake block
@@ -252,6 +261,29 @@ public:
     void SetProofOfStake()
     {
         nFlags |= BLOCK_PROOF_OF_STAKE;
+        SetBlockType();
+    }
+
+    static uint16_t MakeBlockType(bool fProofOfStake, POW_TYPE powType)
+    {
+        return ((uint16_t)powType << 1) | fProofOfStake;
+    }
+
+    //! Cache the block type from nVersion and nFlags, so classifying blocks
+    //! does not need a CBlockHeader copy
+    void SetBlockType()
+    {
+        nBlockType = MakeBlockType(IsProofOfStake(), (POW_TYPE)((nVersion >> 16) & 0xFF));
+    }
+
+    POW_TYPE GetPoWType() const
+    {
+        return (POW_TYPE)(nBlockType >> 1);
+    }
+
+    bool IsSameType(bool fProofOfStake, POW_TYPE powType) const
+    {
+        return nBlockType == MakeBlockType(fProofOfStake, powType);
     }
 
 // pulsar end
@@ -261,6 +293,8 @@ public:
         phashBlock = nullptr;
         pprev = nullptr;
         pskip = nullptr;
+        pprevSameType = nullptr;
+        pindexSyncCheckpoint = nullptr;
         nHeight = 0;
         nFile = 0;
         nDataPos = 0;
@@ -283,6 +317,7 @@ public:
         nMoneySupply = 0;
         nPOWBlockHeight = 0;
         nFlags = 0;
+        nBlockType = 0;
         hashProofOfStake = uint256();
         prevoutStake.SetNull();
         nStakeTime = 0;
@@ -300,6 +335,7 @@ public:
         nTime          = block.nTime;
         nBits          = block.nBits;
         nNonce         = block.nNonce;
+        SetBlockType();
     }
 
     CDiskBlockPos GetBlockPos() const {
@@ -428,6 +464,9 @@ public:
     //! Build the skiplist pointer for this entry.
     void BuildSkip();
 
+    //! pulsar: build the same type predecessor pointer for this entry. Requires nFlags to be set.
+    void BuildPrevSameType();
+
     //! Efficiently find an ancestor of this block.
     CBlockIndex* GetAncestor(int height);
     const CBlockIndex* GetAncestor(int height) const;
@@ -89,6 +89,24 @@ CBlockIndex* GetLastSyncCheckpoint()
     return NULL;
 }
 
+// pulsar: whether pindex is pindexSync or one of its descendants. The answer
+// is cached in the index entry, and a block whose parent is known to descend
+// from the checkpoint does too, so accepting a chain of headers costs O(1) per
+// header instead of a walk back to the checkpoint.
+bool IsDescendantOfSyncCheckpoint(const CBlockIndex* pindex, const CBlockIndex* pindexSync)
+{
+    AssertLockHeld(cs_main);
+    if (pindex->nHeight < pindexSync->nHeight)
+        return false;
+    if (pindex->pindexSyncCheckpoint == pindexSync)
+        return true;
+    if (!(pindex->pprev && pindex->pprev->pindexSyncCheckpoint == pindexSync) &&
+        pindex->GetAncestor(pindexSync->nHeight) != pindexSync)
+        return false;
+    pindex->pindexSyncCheckpoint = pindexSync;
+    return true;
+}
+
 // pulsar: only descendant of current sync-checkpoint is allowed
 bool ValidateSyncCheckpoint(uint256 hashCheckpoint)
 {
@@ -102,14 +120,9 @@ bool ValidateSyncCheckpoint(uint256 hashCheckpoint)
 
     if (pindexCheckpointRecv->nHeight <= pindexSyncCheckpoint->nHeight)
     {
-        // Received an older checkpoint, trace back from current checkpoint
-        // to the same height of the received checkpoint to verify
-        // that current checkpoint should be a descendant block
-        CBlockIndex* pindex = pindexSyncCheckpoint;
-        while (pindex->nHeight > pindexCheckpointRecv->nHeight)
-            if (!(pindex = pindex->pprev))
-                return error("ValidateSyncCheckpoint: pprev1 null - block index structure failure");
-        if (pindex->GetBlockHash() != hashCheckpoint)
+        // Received an older checkpoint, current checkpoint should be a
+        // descendant block of it
+        if (!IsDescendantOfSyncCheckpoint(pindexSyncCheckpoint, pindexCheckpointRecv))
         {
             hashInvalidCheckpoint = hashCheckpoint;
             return error("ValidateSyncCheckpoint: new sync-checkpoint %s is conflicting with current sync-checkpoint %s", hashCheckpoint.ToString(), hashSyncCheckpoint.ToString());
@@ -118,13 +131,8 @@ bool ValidateSyncCheckpoint(uint256 hashCheckpoint)
     }
 
     // Received checkpoint should be a descendant block of the current
-    // checkpoint. Trace back to the same height of current checkpoint
-    // to verify.
-    CBlockIndex* pindex = pindexCheckpointRecv;
-    while (pindex->nHeight > pindexSyncCheckpoint->nHeight)
-        if (!(pindex = pindex->pprev))
-            return error("ValidateSyncCheckpoint: pprev2 null - block index structure failure");
-    if (pindex->GetBlockHash() != hashSyncCheckpoint)
+    // checkpoint
+    if (!IsDescendantOfSyncCheckpoint(pindexCheckpointRecv, pindexSyncCheckpoint))
     {
         hashInvalidCheckpoint = hashCheckpoint;
         return error("ValidateSyncCheckpoint: new sync-checkpoint %s is not a descendant of current sync-checkpoint %s", hashCheckpoint.ToString(), hashSyncCheckpoint.ToString());
@@ -200,43 +208,33 @@ bool AcceptPendingSyncCheckpoint()
 // Automatically select a suitable sync-checkpoint 
 uint256 AutoSelectSyncCheckpoint()
 {
-    // Search backward for a block with specified depth policy
-    const CBlockIndex *pindex = chainActive.Tip();
-    while (pindex->pprev && pindex->nHeight + (int)gArgs.GetArg("-checkpointdepth", -1) > chainActive.Tip()->nHeight)
-        pindex = pindex->pprev;
-    return pindex->GetBlockHash();
+    // Select the block with specified depth policy
+    const int nDepth = std::max(0, (int)gArgs.GetArg("-checkpointdepth", -1));
+    return chainActive[std::max(0, chainActive.Height() - nDepth)]->GetBlockHash();
 }
 
 // Check against synchronized checkpoint
 bool CheckSyncCheckpoint(const uint256& hashBlock, const CBlockIndex* pindexPrev)
 {
-   // skip checks during reindex, except for genesis block
-   if (pindexPrev->nHeight > 0 && chainActive.Height() == 0) return true;
+    // skip checks during reindex, except for genesis block
+    if (pindexPrev->nHeight > 0 && chainActive.Height() == 0) return true;
+
+    int nHeight = pindexPrev->nHeight + 1;
 
-    //ppcTODO - needs rewrite, because it is very slow during accepting headers
+    LOCK(cs_hashSyncCheckpoint);
+    // sync-checkpoint should always be accepted block
+    BlockMap::const_iterator mi = mapBlockIndex.find(hashSyncCheckpoint);
+    if (mi == mapBlockIndex.end())
+        return error("CheckSyncCheckpoint: block index missing for current sync-checkpoint %s", hashSyncCheckpoint.ToString());
+    const CBlockIndex* pindexSync = mi->second;
+
+    if (nHeight > pindexSync->nHeight && !IsDescendantOfSyncCheckpoint(pindexPrev, pindexSync))
+        return false; // only descendant of sync-checkpoint can pass check
+    if (nHeight == pindexSync->nHeight && hashBlock != hashSyncCheckpoint)
+        return false; // same height with sync-checkpoint
+    if (nHeight < pindexSync->nHeight && !mapBlockIndex.count(hashBlock))
+        return false; // lower height than sync-checkpoint
     return true;
-//    int nHeight = pindexPrev->nHeight + 1;
-
-//    LOCK(cs_hashSyncCheckpoint);
-//    // sync-checkpoint should always be accepted block
-//    assert(mapBlockIndex.count(hashSyncCheckpoint));
-//    const CBlockIndex* pindexSync = mapBlockIndex[hashSyncCheckpoint];
-
-//    if (nHeight > pindexSync->nHeight)
-//    {
-//        // trace back to same height as sync-checkpoint
-//        const CBlockIndex* pindex = pindexPrev;
-//        while (pindex->nHeight > pindexSync->nHeight)
-//            if (!(pindex = pindex->pprev))
-//                return error("CheckSyncCheckpoint: pprev null - block index structure failure");
-//        if (pindex->nHeight < pindexSync->nHeight || pindex->GetBlockHash() != hashSyncCheckpoint)
-//            return false; // only descendant of sync-checkpoint can pass check
-//    }
-//    if (nHeight == pindexSync->nHeight && hashBlock != hashSyncCheckpoint)
-//        return false; // same height with sync-checkpoint
-//    if (nHeight < pindexSync->nHeight && !mapBlockIndex.count(hashBlock))
-//        return false; // lower height than sync-checkpoint
-//    return true;
 }
 
 // pulsar: reset synchronized checkpoint to last hardened checkpoint
@@ -384,7 +382,7 @@ bool CSyncCheckpoint::ProcessSyncCheckpoint(CNode* pfrom)
     if (!CheckSignature())
         return false;
 
-    LOCK(cs_hashSyncCheckpoint);
+    LOCK2(cs_main, cs_hashSyncCheckpoint);
     if (!mapBlockIndex.count(hashCheckpoint))
     {
         // We haven't received the checkpoint chain, keep the checkpoint as pending
@@ -24,6 +24,7 @@ bool IsSyncCheckpointEnforced();
 void SetCheckpointEnforce(bool fEnforce);
 bool AcceptPendingSyncCheckpoint();
 uint256 AutoSelectSyncCheckpoint();
+bool IsDescendantOfSyncCheckpoint(const CBlockIndex* pindex, const CBlockIndex* pindexSync);
 bool CheckSyncCheckpoint(const uint256& hashBlock, const CBlockIndex* pindexPrev);
 bool ResetSyncCheckpoint();
 void AskForPendingSyncCheckpoint(CNode* pfrom);
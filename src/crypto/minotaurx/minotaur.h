@@ -59,7 +59,7 @@ struct TortureGarden {
 };
 
 // Get a 64-byte hash for given 64-byte input, using given TortureGarden contexts and given algo index
-uint512 GetHash(uint512 inputHash, TortureGarden *garden, unsigned int algo, yespower_local_t *local) {
+inline uint512 GetHash(uint512 inputHash, TortureGarden *garden, unsigned int algo, yespower_local_t *local) {
     uint512 outputHash;
     switch (algo) {
         case 0:
@@ -159,7 +159,7 @@ uint512 GetHash(uint512 inputHash, TortureGarden *garden, unsigned int algo, yes
 }
 
 // Recursively traverse a given torture garden starting with a given hash and given node within the garden. The hash is overwritten with the final hash.
-uint512 TraverseGarden(TortureGarden *garden, uint512 hash, TortureNode *node, yespower_local_t *local) {
+inline uint512 TraverseGarden(TortureGarden *garden, uint512 hash, TortureNode *node, yespower_local_t *local) {
     uint512 partialHash = GetHash(hash, garden, node->algo, local);
 
 #ifdef MINOTAUR_DEBUG
@@ -179,48 +179,49 @@ uint512 TraverseGarden(TortureGarden *garden, uint512 hash, TortureNode *node, y
 }
 
 // Associate child nodes with a parent node
-void LinkNodes(TortureNode *parent, TortureNode *childLeft, TortureNode *childRight) {
+inline void LinkNodes(TortureNode *parent, TortureNode *childLeft, TortureNode *childRight) {
     parent->childLeft = childLeft;
     parent->childRight = childRight;
 }
 
-// Produce a Minotaur 32-byte hash from variable length data
+// Create torture garden nodes. Note that both sides of 19 and 20 lead to 21, and 21 has no children (to make traversal complete).
+// Every path through the garden stops at 7 nodes. The links are the same for every hash, only the node algos change.
+inline void PlantTortureGarden(TortureGarden *garden) {
+    LinkNodes(&garden->nodes[0], &garden->nodes[1], &garden->nodes[2]);
+    LinkNodes(&garden->nodes[1], &garden->nodes[3], &garden->nodes[4]);
+    LinkNodes(&garden->nodes[2], &garden->nodes[5], &garden->nodes[6]);
+    LinkNodes(&garden->nodes[3], &garden->nodes[7], &garden->nodes[8]);
+    LinkNodes(&garden->nodes[4], &garden->nodes[9], &garden->nodes[10]);
+    LinkNodes(&garden->nodes[5], &garden->nodes[11], &garden->nodes[12]);
+    LinkNodes(&garden->nodes[6], &garden->nodes[13], &garden->nodes[14]);
+    LinkNodes(&garden->nodes[7], &garden->nodes[15], &garden->nodes[16]);
+    LinkNodes(&garden->nodes[8], &garden->nodes[15], &garden->nodes[16]);
+    LinkNodes(&garden->nodes[9], &garden->nodes[15], &garden->nodes[16]);
+    LinkNodes(&garden->nodes[10], &garden->nodes[15], &garden->nodes[16]);
+    LinkNodes(&garden->nodes[11], &garden->nodes[17], &garden->nodes[18]);
+    LinkNodes(&garden->nodes[12], &garden->nodes[17], &garden->nodes[18]);
+    LinkNodes(&garden->nodes[13], &garden->nodes[17], &garden->nodes[18]);
+    LinkNodes(&garden->nodes[14], &garden->nodes[17], &garden->nodes[18]);
+    LinkNodes(&garden->nodes[15], &garden->nodes[19], &garden->nodes[20]);
+    LinkNodes(&garden->nodes[16], &garden->nodes[19], &garden->nodes[20]);
+    LinkNodes(&garden->nodes[17], &garden->nodes[19], &garden->nodes[20]);
+    LinkNodes(&garden->nodes[18], &garden->nodes[19], &garden->nodes[20]);
+    LinkNodes(&garden->nodes[19], &garden->nodes[21], &garden->nodes[21]);
+    LinkNodes(&garden->nodes[20], &garden->nodes[21], &garden->nodes[21]);
+    garden->nodes[21].childLeft = NULL;
+    garden->nodes[21].childRight = NULL;
+}
+
+// Produce a Minotaur 32-byte hash from variable length data, using a garden prepared by PlantTortureGarden
 // Optionally, use the MinotaurX hardened hash.
 // Optionally, use provided thread-local memory for yespower.
-template<typename T> uint256 Minotaur(const T begin, const T end, bool minotaurX, yespower_local_t *local = NULL) {
-    // Create torture garden nodes. Note that both sides of 19 and 20 lead to 21, and 21 has no children (to make traversal complete).
-    // Every path through the garden stops at 7 nodes.
-    TortureGarden garden;
-    LinkNodes(&garden.nodes[0], &garden.nodes[1], &garden.nodes[2]);
-    LinkNodes(&garden.nodes[1], &garden.nodes[3], &garden.nodes[4]);
-    LinkNodes(&garden.nodes[2], &garden.nodes[5], &garden.nodes[6]);
-    LinkNodes(&garden.nodes[3], &garden.nodes[7], &garden.nodes[8]);
-    LinkNodes(&garden.nodes[4], &garden.nodes[9], &garden.nodes[10]);
-    LinkNodes(&garden.nodes[5], &garden.nodes[11], &garden.nodes[12]);
-    LinkNodes(&garden.nodes[6], &garden.nodes[13], &garden.nodes[14]);
-    LinkNodes(&garden.nodes[7], &garden.nodes[15], &garden.nodes[16]);
-    LinkNodes(&garden.nodes[8], &garden.nodes[15], &garden.nodes[16]);
-    LinkNodes(&garden.nodes[9], &garden.nodes[15], &garden.nodes[16]);
-    LinkNodes(&garden.nodes[10], &garden.nodes[15], &garden.nodes[16]);
-    LinkNodes(&garden.nodes[11], &garden.nodes[17], &garden.nodes[18]);
-    LinkNodes(&garden.nodes[12], &garden.nodes[17], &garden.nodes[18]);
-    LinkNodes(&garden.nodes[13], &garden.nodes[17], &garden.nodes[18]);
-    LinkNodes(&garden.nodes[14], &garden.nodes[17], &garden.nodes[18]);
-    LinkNodes(&garden.nodes[15], &garden.nodes[19], &garden.nodes[20]);
-    LinkNodes(&garden.nodes[16], &garden.nodes[19], &garden.nodes[20]);
-    LinkNodes(&garden.nodes[17], &garden.nodes[19], &garden.nodes[20]);
-    LinkNodes(&garden.nodes[18], &garden.nodes[19], &garden.nodes[20]);
-    LinkNodes(&garden.nodes[19], &garden.nodes[21], &garden.nodes[21]);
-    LinkNodes(&garden.nodes[20], &garden.nodes[21], &garden.nodes[21]);
-    garden.nodes[21].childLeft = NULL;
-    garden.nodes[21].childRight = NULL;
-        
+template<typename T> uint256 Minotaur(const T begin, const T end, bool minotaurX, yespower_local_t *local, TortureGarden *garden) {
     // Find initial sha512 hash of the variable length data
     uint512 hash;
     static unsigned char empty[1];
-    sph_sha512_init(&garden.context_sha2);
-    sph_sha512(&garden.context_sha2, (begin == end ? empty : static_cast<const void*>(&begin[0])), (end - begin) * sizeof(begin[0]));
-    sph_sha512_close(&garden.context_sha2, static_cast<void*>(&hash));
+    sph_sha512_init(&garden->context_sha2);
+    sph_sha512(&garden->context_sha2, (begin == end ? empty : static_cast<const void*>(&begin[0])), (end - begin) * sizeof(begin[0]));
+    sph_sha512_close(&garden->context_sha2, static_cast<void*>(&hash));
 
 #ifdef MINOTAUR_DEBUG
     printf("** Initial hash:\t\t%s\n", hash.ToString().c_str());
@@ -229,14 +230,14 @@ template<typename T> uint256 Minotaur(const T begin, const T end, bool minotaurX
 
     // Assign algos to torture net nodes based on initial hash
     for (int i = 0; i < 22; i++)
-        garden.nodes[i].algo = hash.ByteAt(i) % MINOTAUR_ALGO_COUNT;
+        garden->nodes[i].algo = hash.ByteAt(i) % MINOTAUR_ALGO_COUNT;
 
     // Hardened garden gates on MinotaurX
     if (minotaurX)
-        garden.nodes[21].algo = MINOTAUR_ALGO_COUNT;
+        garden->nodes[21].algo = MINOTAUR_ALGO_COUNT;
 
     // Send the initial hash through the torture garden
-    hash = TraverseGarden(&garden, hash, &garden.nodes[0], local);
+    hash = TraverseGarden(garden, hash, &garden->nodes[0], local);
 
 #ifdef MINOTAUR_DEBUG
     printf("** Final hash:\t\t\t%s\n", uint256(hash).ToString().c_str());
@@ -247,4 +248,13 @@ template<typename T> uint256 Minotaur(const T begin, const T end, bool minotaurX
     return uint256(hash);
 }
 
+// Produce a Minotaur 32-byte hash from variable length data
+// Optionally, use the MinotaurX hardened hash.
+// Optionally, use provided thread-local memory for yespower.
+template<typename T> uint256 Minotaur(const T begin, const T end, bool minotaurX, yespower_local_t *local = NULL) {
+    TortureGarden garden;
+    PlantTortureGarden(&garden);
+    return Minotaur(begin, end, minotaurX, local, &garden);
+}
+
 #endif // LCC_CRYPTO_MINOTAURX_MINOTAUR_H
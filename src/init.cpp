@@ -25,7 +25,9 @@
 #include <netbase.h>
 #include <net.h>
 #include <net_processing.h>
+#include <networkstats.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <rpc/server.h>
 #include <rpc/register.h>
 #include <rpc/safemode.h>
@@ -33,6 +35,8 @@
 #include <script/standard.h>
 #include <script/sigcache.h>
 #include <scheduler.h>
+#include <stakemodifiers.h>
+#include <supplyindex.h>
 #include <timedata.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -219,6 +223,11 @@ void Shutdown()
     // CValidationInterface callbacks, flush them...
     GetMainSignals().FlushBackgroundCallbacks();
 
+    if (g_supplyindex) {
+        UnregisterValidationInterface(g_supplyindex.get());
+        g_supplyindex.reset();
+    }
+
     // Any future callbacks will be dropped. This should absolutely be safe - if
     // missing a callback results in an unrecoverable situation, unclean shutdown
     // would too. The only reason to do the above flushes is to let the wallet catch
@@ -233,6 +242,7 @@ void Shutdown()
         pcoinsTip.reset();
         pcoinscatcher.reset();
         pcoinsdbview.reset();
+        pstakemodifiers.reset();
         pblocktree.reset();
     }
 #ifdef ENABLE_WALLET
@@ -247,6 +257,11 @@ void Shutdown()
     }
 #endif
 
+    if (g_networkstats) {
+        UnregisterValidationInterface(g_networkstats.get());
+        g_networkstats.reset();
+    }
+
 #ifndef WIN32
     try {
         fs::remove(GetPidFile());
@@ -369,6 +384,9 @@ std::string HelpMessage(HelpMessageMode mode)
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
+    strUsage += HelpMessageOpt("-stakeindex", strprintf(_("Maintain an index of transaction outputs, used to check proof-of-stake without reading block files (default: %u)"), DEFAULT_STAKEINDEX));
+    strUsage += HelpMessageOpt("-stakemodifiertable", strprintf(_("Maintain a table of the stake modifier of every block in stakemodifiers.dat, used by the getstakemodifiers rpc call and external tools (default: %u)"), DEFAULT_STAKEMODIFIERTABLE));
+    strUsage += HelpMessageOpt("-supplyindex", strprintf(_("Maintain an index of money supply and minting statistics, used by the getsupplystats rpc call (default: %u)"), DEFAULT_SUPPLYINDEX));
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
@@ -421,6 +439,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubhashtx=<address>", _("Enable publish hash transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubnetworkstats=<address>", _("Enable publish network hashrate and stake weight estimates in <address>"));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -429,6 +448,7 @@ std::string HelpMessage(HelpMessageMode mode)
     {
         strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), DEFAULT_CHECKBLOCKS));
         strUsage += HelpMessageOpt("-checklevel=<n>", strprintf(_("How thorough the block verification of -checkblocks is (0-4, default: %u)"), DEFAULT_CHECKLEVEL));
+        strUsage += HelpMessageOpt("-checkblockindexpow=<n>", strprintf("Check again in the background after startup the proof of work that was trusted while loading the block index, for the last <n> blocks of the active chain, or for all entries with \"all\" (default: %u)", DEFAULT_CHECKBLOCKINDEXPOW));
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
@@ -456,6 +476,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxpowcachesize=<n>", strprintf("Limit proof-of-work cache size to <n> MiB (default: %u)", DEFAULT_MAX_POW_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
     strUsage += HelpMessageOpt("-printtoconsole", _("Send trace/debug info to console instead of debug.log file"));
@@ -500,6 +521,8 @@ std::string HelpMessage(HelpMessageMode mode)
     }
 
     strUsage += HelpMessageOpt("-powalgo=curvehash|minotaurx", strprintf(_("Default pow mining algorithm. Miners who can't easily adjust their getblocktemplate calls should use this argument to set their preferred mining algorithm. (default: %s)"), DEFAULT_POW_TYPE));
+    strUsage += HelpMessageOpt("-minerpin", strprintf(_("Pin each mining thread to its own CPU, spread over the NUMA nodes (Linux only, default: %u)"), DEFAULT_MINER_PIN));
+    strUsage += HelpMessageOpt("-minerbench=<n>", strprintf(_("Measure the hash rate of each mining algorithm with <n> threads (0 = all cores) for %d seconds each, log the results and exit"), MINER_BENCH_SECONDS));
     return strUsage;
 }
 
@@ -960,6 +983,11 @@ bool AppInitParameterInteraction()
     }
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fStakeIndex = gArgs.GetBoolArg("-stakeindex", DEFAULT_STAKEINDEX);
+
+    // pulsar: the supply index is built from the block and undo files
+    if (gArgs.GetArg("-prune", 0) && gArgs.GetBoolArg("-supplyindex", DEFAULT_SUPPLYINDEX))
+        return InitError(_("Prune mode is incompatible with -supplyindex."));
 
     hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1099,6 +1127,7 @@ bool AppInitLockDataDirectory()
 bool AppInitMain()
 {
     const CChainParams& chainparams = Params();
+    int64_t nStartupTime = GetTimeMillis();
     // ********************************************************* Step 4a: application initialization
 #ifndef WIN32
     CreatePidFile(GetPidFile(), getpid());
@@ -1133,11 +1162,14 @@ bool AppInitMain()
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitPoWCache();
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
+    LogPrintf("Using %u threads for script and header PoW verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadPoWCheck);
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -1167,6 +1199,13 @@ bool AppInitMain()
             return InitError(_("Unable to start HTTP server. See debug log for details."));
     }
 
+    // pulsar: -minerbench only measures the mining hash rates
+    if (gArgs.IsArgSet("-minerbench")) {
+        MinerBench(gArgs.GetArg("-minerbench", 0), MINER_BENCH_SECONDS);
+        StartShutdown();
+        return true;
+    }
+
     int64_t nStart;
 
     // ********************************************************* Step 5: verify wallet database integrity
@@ -1273,6 +1312,10 @@ bool AppInitMain()
             return InitError(ResolveErrMsg("externalip", strAddr));
     }
 
+    // pulsar: keep the network estimates up to date for getnetworkstats and -zmqpubnetworkstats
+    g_networkstats.reset(new CNetworkStatsEstimator());
+    RegisterValidationInterface(g_networkstats.get());
+
 #if ENABLE_ZMQ
     pzmqNotificationInterface = CZMQNotificationInterface::Create();
 
@@ -1412,6 +1455,15 @@ bool AppInitMain()
                     }
                 }
 
+                // pulsar: load the stake modifier table, keeping the records that still match the active chain
+                if (gArgs.GetBoolArg("-stakemodifiertable", DEFAULT_STAKEMODIFIERTABLE)) {
+                    LOCK(cs_main);
+                    pstakemodifiers.reset(new CStakeModifierTable(GetDataDir() / "stakemodifiers.dat"));
+                    pstakemodifiers->Load();
+                } else {
+                    pstakemodifiers.reset();
+                }
+
                 if (!is_coinsview_empty) {
                     uiInterface.InitMessage(_("Verifying blocks..."));
 
@@ -1509,6 +1561,12 @@ bool AppInitMain()
         vImportFiles.push_back(strFile);
     }
 
+    // Seed the network estimates with the loaded chain, new tips arrive through UpdatedBlockTip
+    {
+        LOCK(cs_main);
+        g_networkstats->Update(chainActive.Tip());
+    }
+
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
@@ -1527,6 +1585,13 @@ bool AppInitMain()
         return false;
     }
 
+    // pulsar: build the supply index in the background, it follows the chain once caught up
+    if (gArgs.GetBoolArg("-supplyindex", DEFAULT_SUPPLYINDEX)) {
+        g_supplyindex.reset(new CSupplyIndex(SUPPLYINDEX_CACHE_SIZE));
+        RegisterValidationInterface(g_supplyindex.get());
+        threadGroup.create_thread(boost::bind(&CSupplyIndex::ThreadSync, g_supplyindex.get()));
+    }
+
     // ********************************************************* Step 11: start node
 
     int chain_active_height;
@@ -1607,6 +1672,13 @@ bool AppInitMain()
 
     SetRPCWarmupFinished();
     uiInterface.InitMessage(_("Done loading"));
+    LogPrintf("Startup completed in %dms\n", GetTimeMillis() - nStartupTime);
+
+    // pulsar: the proof of work of the block index was trusted while loading, check it now if asked to
+    std::string strCheckBlockIndexPoW = gArgs.GetArg("-checkblockindexpow", std::to_string(DEFAULT_CHECKBLOCKINDEXPOW));
+    int nCheckBlockIndexPoW = strCheckBlockIndexPoW == "all" ? -1 : std::max(0, atoi(strCheckBlockIndexPoW));
+    if (nCheckBlockIndexPoW != 0)
+        threadGroup.create_thread(boost::bind(&ThreadCheckBlockIndexPoW, nCheckBlockIndexPoW));
 
 #ifdef ENABLE_WALLET
     StartWallets(scheduler);
@@ -3,16 +3,20 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <kernel.h>
+#include <arith_uint256.h>
 #include <chainparams.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
 #include <util.h>
 #include <validation.h>
 #include <streams.h>
 #include <timedata.h>
-#include <bignum.h>
+#include <hash.h>
 #include <txdb.h>
 #include <consensus/validation.h>
 #include <random.h>
 #include <script/interpreter.h>
+#include <script/sigcache.h>
 
 #include <boost/assign/list_of.hpp>
 
@@ -28,8 +32,13 @@ uint256 ComputeStakeModifier(const CBlockIndex* pindexPrev, const uint256& kerne
     if (!pindexPrev)
         return uint256();  // genesis block's modifier is 0
 
+    return ComputeStakeModifier(pindexPrev->bnStakeModifier, kernel);
+}
+
+uint256 ComputeStakeModifier(const uint256& bnStakeModifierPrev, const uint256& kernel)
+{
     CDataStream ss(SER_GETHASH, 0);
-    ss << kernel << pindexPrev->bnStakeModifier;
+    ss << kernel << bnStakeModifierPrev;
     return Hash(ss.begin(), ss.end());
 }
 
@@ -54,41 +63,77 @@ uint256 ComputeStakeModifier(const CBlockIndex* pindexPrev, const uint256& kerne
 //   quantities so as to generate blocks faster, degrading the system back into
 //   a proof-of-work situation.
 //
-bool CheckStakeKernelHash(unsigned int nBits, CBlockIndex* pindexPrev, const CBlockHeader& blockFrom, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fPrintProofOfStake)
+bool GetStakeKernelTarget(unsigned int nBits, CAmount nValueIn, arith_uint256& bnTarget, bool& fAnyHash)
 {
-    unsigned int nTimeBlockFrom = blockFrom.GetBlockTime();
-    if (nTimeTx < txPrev->nTime)  // Transaction timestamp violation
-        return error("CheckStakeKernelHash() : nTime violation");
+    // Base target, as a magnitude and a sign
+    bool fNegative, fOverflow;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    fAnyHash = false;
 
-    // Base target
-    CBigNum bnTarget;
-    bnTarget.SetCompact(nBits);
+    // Weighted target
+    if (nValueIn == 0 || (bnTarget == 0 && !fOverflow)) {
+        bnTarget = 0;
+        return true;
+    }
+    if (fNegative != (nValueIn < 0))
+        return false;
+    uint64_t nWeight = nValueIn < 0 ? -(uint64_t)nValueIn : nValueIn;
+
+    // Products of 2^256 or more are met by any hash
+    unsigned int nWeightBits = 0;
+    while (nWeightBits < 64 && (nWeight >> nWeightBits) != 0)
+        nWeightBits++;
+    if (fOverflow || (bnTarget.bits() + nWeightBits > 256 && bnTarget > ~arith_uint256() / arith_uint256(nWeight))) {
+        bnTarget = ~arith_uint256();
+        fAnyHash = true;
+        return true;
+    }
+    bnTarget *= arith_uint256(nWeight);
+    return true;
+}
+
+uint256 GetStakeKernelHash(const uint256& bnStakeModifier, unsigned int nTimeTxPrev, const COutPoint& prevout, unsigned int nTimeTx)
+{
+    // Same bytes as serializing the fields one after the other
+    unsigned char data[76];
+    memcpy(data, bnStakeModifier.begin(), 32);
+    WriteLE32(data + 32, nTimeTxPrev);
+    memcpy(data + 36, prevout.hash.begin(), 32);
+    WriteLE32(data + 68, prevout.n);
+    WriteLE32(data + 72, nTimeTx);
+
+    uint256 hash;
+    CHash256().Write(data, sizeof(data)).Finalize(hash.begin());
+    return hash;
+}
+
+bool CheckStakeKernelHash(unsigned int nBits, CBlockIndex* pindexPrev, unsigned int nTimeBlockFrom, unsigned int nTimeTxPrev, CAmount nValueIn, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fPrintProofOfStake)
+{
+    if (nTimeTx < nTimeTxPrev)  // Transaction timestamp violation
+        return error("CheckStakeKernelHash() : nTime violation");
 
     // Weighted target
-    int64_t nValueIn = txPrev->vout[prevout.n].nValue;
-    CBigNum bnWeight = CBigNum(nValueIn);
-    bnTarget *= bnWeight;
+    arith_uint256 bnTarget;
+    bool fAnyHash;
+    bool fTargetValid = GetStakeKernelTarget(nBits, nValueIn, bnTarget, fAnyHash);
 
-    targetProofOfStake = bnTarget.getuint256();
+    targetProofOfStake = fTargetValid ? ArithToUint256(bnTarget) : uint256();
 
     uint256 bnStakeModifier = pindexPrev->bnStakeModifier;
 
     // Calculate hash
-    CDataStream ss(SER_GETHASH, 0);
-    ss << bnStakeModifier;
-    ss << txPrev->nTime << prevout.hash << prevout.n << nTimeTx;
-    hashProofOfStake = Hash(ss.begin(), ss.end());
+    hashProofOfStake = GetStakeKernelHash(bnStakeModifier, nTimeTxPrev, prevout, nTimeTx);
 
     if (fPrintProofOfStake)
     {
         LogPrint(BCLog::ALL, "check modifier%s nTimeBlockFrom=%u nTimeTxPrev=%u nPrevout=%u nTimeTx=%u hashProof=%s\n",
                   bnStakeModifier.ToString(),
-                  nTimeBlockFrom, txPrev->nTime, prevout.n, nTimeTx,
+                  nTimeBlockFrom, nTimeTxPrev, prevout.n, nTimeTx,
                   hashProofOfStake.ToString());
     }
 
     // Now check if proof-of-stake hash meets target protocol
-    if (CBigNum(hashProofOfStake) > bnTarget) {
+    if (!fTargetValid || (!fAnyHash && UintToArith256(hashProofOfStake) > bnTarget)) {
         return false;
     }
 
@@ -96,15 +141,20 @@ bool CheckStakeKernelHash(unsigned int nBits, CBlockIndex* pindexPrev, const CBl
     {
         LogPrint(BCLog::ALL, "pass modifier=%s nTimeBlockFrom=%u nTimeTxPrev=%u nPrevout=%u nTimeTx=%u hashProof=%s\n",
                   bnStakeModifier.ToString(),
-                  nTimeBlockFrom, txPrev->nTime, prevout.n, nTimeTx,
+                  nTimeBlockFrom, nTimeTxPrev, prevout.n, nTimeTx,
                   hashProofOfStake.ToString());
     }
 
     return true;
 }
 
+bool CheckStakeKernelHash(unsigned int nBits, CBlockIndex* pindexPrev, const CBlockHeader& blockFrom, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fPrintProofOfStake)
+{
+    return CheckStakeKernelHash(nBits, pindexPrev, blockFrom.GetBlockTime(), txPrev->nTime, txPrev->vout[prevout.n].nValue, prevout, nTimeTx, hashProofOfStake, targetProofOfStake, fPrintProofOfStake);
+}
+
 // Check kernel hash target and coinstake signature
-bool CheckProofOfStake(CValidationState &state, CBlockIndex* pindexPrev, const CTransactionRef& tx, unsigned int nBits, uint256& hashProofOfStake, uint256& targetProofOfStake)
+bool CheckProofOfStake(CValidationState &state, CBlockIndex* pindexPrev, const CTransactionRef& tx, unsigned int nBits, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fCheckScript)
 {
     if (!tx->IsCoinStake())
         return error("CheckProofOfStake() : called on non-coinstake %s", tx->GetHash().ToString());
@@ -112,22 +162,38 @@ bool CheckProofOfStake(CValidationState &state, CBlockIndex* pindexPrev, const C
     // Kernel (input 0) must match the stake hash target per coin age (nBits)
     const CTxIn& txin = tx->vin[0];
 
-    // Transaction index is required to get to block header
-    if (!fTxIndex)
-        return error("CheckProofOfStake() : transaction index not available");
-
-    // Get transaction index for the previous transaction
-    CDiskTxPos postx;
-    if (!pblocktree->ReadTxIndex(txin.prevout.hash, postx))
-        return error("CheckProofOfStake() : tx index not found");  // tx index not found
-
     // Read txPrev and header of its block
     CBlockHeader header;
-    CTransactionRef txPrev;
-    CBlock blockKernel; // block containing stake kernel, GetTransaction should only fill the header.
-    if (!GetTransaction(txin.prevout.hash, txPrev, Params().GetConsensus(), blockKernel)) {
-        LogPrintf("ERROR: %s: prevout-not-in-chain\n", __func__);
-        return error("prevout-not-in-chain");
+    CStakePrevout prevout;
+    // The stake index follows the active chain, so an entry only holds for a
+    // block on another branch if the block holding the output is shared. An
+    // entry left over from a reorg while the index was off names a block that
+    // is no longer in the active chain.
+    bool fIndexed = fStakeIndex && pblocktree->ReadStakeIndex(txin.prevout, prevout) &&
+                    prevout.nHeight <= pindexPrev->nHeight && chainActive[prevout.nHeight] &&
+                    chainActive[prevout.nHeight]->GetBlockHash() == prevout.hashBlock &&
+                    pindexPrev->GetAncestor(prevout.nHeight) == chainActive[prevout.nHeight];
+    if (!fIndexed) {
+        // Outputs of blocks connected without the stake index come from the transaction index
+        if (!fTxIndex)
+            return error("CheckProofOfStake() : transaction index not available");
+
+        // Get transaction index for the previous transaction
+        CDiskTxPos postx;
+        if (!pblocktree->ReadTxIndex(txin.prevout.hash, postx))
+            return error("CheckProofOfStake() : tx index not found");  // tx index not found
+
+        CTransactionRef txPrev;
+        CBlock blockKernel; // block containing stake kernel, GetTransaction should only fill the header.
+        if (!GetTransaction(txin.prevout.hash, txPrev, Params().GetConsensus(), blockKernel)) {
+            LogPrintf("ERROR: %s: prevout-not-in-chain\n", __func__);
+            return error("prevout-not-in-chain");
+        }
+        if (txPrev->GetHash() != txin.prevout.hash)
+            return error("%s() : txid mismatch in CheckProofOfStake()", __PRETTY_FUNCTION__);
+        if (txin.prevout.n >= txPrev->vout.size())
+            return error("CheckProofOfStake() : prevout out of range");
+        prevout = CStakePrevout(txPrev->vout[txin.prevout.n], txPrev->nTime, 0, uint256());
     }
     int nDepth;
 
@@ -141,20 +207,19 @@ bool CheckProofOfStake(CValidationState &state, CBlockIndex* pindexPrev, const C
         return error("CheckProofOfStake() : tried to stake at depth %d", nDepth + 1);
     }
 
-    if (txPrev->GetHash() != txin.prevout.hash)
-        return error("%s() : txid mismatch in CheckProofOfStake()", __PRETTY_FUNCTION__);
-
-    // Verify signature
+    // Verify signature, leaving it in the signature cache for ConnectBlock()
+    if (fCheckScript)
     {
         int nIn = 0;
-        const CTxOut& prevOut = txPrev->vout[tx->vin[nIn].prevout.n];
-        TransactionSignatureChecker checker(&(*tx), nIn, prevOut.nValue, PrecomputedTransactionData(*tx));
+        const CTxOut& prevOut = prevout.out;
+        PrecomputedTransactionData txdata(*tx);
+        CachingTransactionSignatureChecker checker(&(*tx), nIn, prevOut.nValue, true, txdata);
 
         if (!VerifyScript(tx->vin[nIn].scriptSig, prevOut.scriptPubKey, &(tx->vin[nIn].scriptWitness), SCRIPT_VERIFY_P2SH, checker, nullptr))
             return state.DoS(100, false, REJECT_INVALID, "invalid-pos-script", false, strprintf("%s: VerifyScript failed on coinstake %s", __func__, tx->GetHash().ToString()));
     }
 
-    if (!CheckStakeKernelHash(nBits, pindexPrev, header, txPrev, txin.prevout, tx->nTime, hashProofOfStake, targetProofOfStake, gArgs.GetBoolArg("-debug", false)))
+    if (!CheckStakeKernelHash(nBits, pindexPrev, header.GetBlockTime(), prevout.nTime, prevout.out.nValue, txin.prevout, tx->nTime, hashProofOfStake, targetProofOfStake, gArgs.GetBoolArg("-debug", false)))
         return state.DoS(1, error("CheckProofOfStake() : INFO: check kernel failed on coinstake %s, hashProof=%s", tx->GetHash().ToString(), hashProofOfStake.ToString())); // may occur during initial download or if behind on block chain sync
 
     return true;
@@ -167,18 +232,82 @@ bool CheckCoinStakeTimestamp(int64_t nTimeBlock, int64_t nTimeTx)
 }
 
 // Used only when staking, not during validation
-bool CheckKernel(unsigned int nBits, CBlockIndex *pindexPrev, const CBlockHeader& header, const CTransactionRef& txPrev, const COutPoint &prevoutStake, unsigned int nTime)
+bool CheckKernel(unsigned int nBits, CBlockIndex *pindexPrev, const uint256& hashBlockFrom, unsigned int nTimeBlockFrom, unsigned int nTimeTxPrev, CAmount nValueIn, const COutPoint &prevoutStake, unsigned int nTime)
 {
     uint256 hashProofOfStake, targetProofOfStake;
     int nDepth;
     if (IsReductionActive(chainActive.Tip(), Params().GetConsensus()))
     {
-        if (IsConfirmedInNPrevBlocks(header.GetHash(), pindexPrev, Params().GetConsensus().nStakeMinConfirmations_Reduction - 1, nDepth))
+        if (IsConfirmedInNPrevBlocks(hashBlockFrom, pindexPrev, Params().GetConsensus().nStakeMinConfirmations_Reduction - 1, nDepth))
             return false;
     }
-    else if (IsConfirmedInNPrevBlocks(header.GetHash(), pindexPrev, Params().GetConsensus().nStakeMinConfirmations - 1, nDepth)) {
+    else if (IsConfirmedInNPrevBlocks(hashBlockFrom, pindexPrev, Params().GetConsensus().nStakeMinConfirmations - 1, nDepth)) {
         return false;
     }
 
-    return CheckStakeKernelHash(nBits, pindexPrev, header, txPrev, prevoutStake, nTime, hashProofOfStake, targetProofOfStake);
-}
\ No newline at end of file
+    return CheckStakeKernelHash(nBits, pindexPrev, nTimeBlockFrom, nTimeTxPrev, nValueIn, prevoutStake, nTime, hashProofOfStake, targetProofOfStake);
+}
+
+bool CheckKernel(unsigned int nBits, CBlockIndex *pindexPrev, const CBlockHeader& header, const CTransactionRef& txPrev, const COutPoint &prevoutStake, unsigned int nTime)
+{
+    return CheckKernel(nBits, pindexPrev, header.GetHash(), header.GetBlockTime(), txPrev->nTime, txPrev->vout[prevoutStake.n].nValue, prevoutStake, nTime);
+}
+
+bool SearchStakeKernel(unsigned int nBits, CBlockIndex* pindexPrev, const std::vector<CStakeKernelInput>& vInputs, unsigned int nTimeFrom, unsigned int nTimeTo, unsigned int& nTimeRet, size_t& nInputRet)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const int nMaxDepth = (IsReductionActive(chainActive.Tip(), params) ? params.nStakeMinConfirmations_Reduction : params.nStakeMinConfirmations) - 1;
+
+    bool fFound = false;
+    for (size_t i = 0; i < vInputs.size(); i++) {
+        const CStakeKernelInput& input = vInputs[i];
+
+        // Only timestamps before the best one found so far can improve on it
+        unsigned int nFirst = std::max(nTimeFrom, input.nTimeTxPrev);
+        if (fFound && nFirst >= nTimeRet)
+            continue;
+        unsigned int nLast = fFound ? nTimeRet - 1 : nTimeTo;
+        if (nFirst > nLast)
+            continue;
+
+        int nDepth;
+        if (IsConfirmedInNPrevBlocks(input.hashBlockFrom, pindexPrev, nMaxDepth, nDepth))
+            continue;
+
+        // Weighted target
+        arith_uint256 bnTarget;
+        bool fAnyHash;
+        if (!GetStakeKernelTarget(nBits, input.nValue, bnTarget, fAnyHash))
+            continue;
+
+        // Same bytes as GetStakeKernelHash: everything but the
+        // trailing nTimeTx is fixed for this input, so hash it only once
+        unsigned char buf[4];
+        CSHA256 hasherInput;
+        hasherInput.Write(pindexPrev->bnStakeModifier.begin(), pindexPrev->bnStakeModifier.size());
+        WriteLE32(buf, input.nTimeTxPrev);
+        hasherInput.Write(buf, sizeof(buf));
+        hasherInput.Write(input.prevout.hash.begin(), input.prevout.hash.size());
+        WriteLE32(buf, input.prevout.n);
+        hasherInput.Write(buf, sizeof(buf));
+
+        for (unsigned int nTimeTx = nFirst; ; nTimeTx++) {
+            uint256 hashProofOfStake;
+            WriteLE32(buf, nTimeTx);
+            CSHA256(hasherInput).Write(buf, sizeof(buf)).Finalize(hashProofOfStake.begin());
+            CSHA256().Write(hashProofOfStake.begin(), hashProofOfStake.size()).Finalize(hashProofOfStake.begin());
+
+            if (fAnyHash || UintToArith256(hashProofOfStake) <= bnTarget) {
+                LogPrint(BCLog::ALL, "SearchStakeKernel() : pass nTimeTxPrev=%u prevout=%s nTimeTx=%u hashProof=%s\n",
+                          input.nTimeTxPrev, input.prevout.ToString(), nTimeTx, hashProofOfStake.ToString());
+                nTimeRet = nTimeTx;
+                nInputRet = i;
+                fFound = true;
+                break;
+            }
+            if (nTimeTx == nLast)
+                break;
+        }
+    }
+    return fFound;
+}
@@ -5,6 +5,8 @@
 #ifndef PULSAR_KERNEL_H
 #define PULSAR_KERNEL_H
 
+#include <amount.h>
+#include <arith_uint256.h>
 #include <primitives/transaction.h> // CTransaction(Ref)
 
 class CBlockIndex;
@@ -18,14 +20,26 @@ static const int MODIFIER_INTERVAL_RATIO = 3;
 
 // Compute the hash modifier for proof-of-stake
 uint256 ComputeStakeModifier(const CBlockIndex* pindexPrev, const uint256& kernel);
+// Same, from the modifier of the previous block (not for the genesis block)
+uint256 ComputeStakeModifier(const uint256& bnStakeModifierPrev, const uint256& kernel);
+
+// Compute the kernel target weighted by the kernel input's value nValueIn
+// Returns false if no hash can meet it, sets fAnyHash if any hash does
+bool GetStakeKernelTarget(unsigned int nBits, CAmount nValueIn, arith_uint256& bnTarget, bool& fAnyHash);
+
+// Compute the kernel hash of input prevout at time nTimeTx
+uint256 GetStakeKernelHash(const uint256& bnStakeModifier, unsigned int nTimeTxPrev, const COutPoint& prevout, unsigned int nTimeTx);
 
 // Check whether stake kernel meets hash target
 // Sets hashProofOfStake on success return
 bool CheckStakeKernelHash(unsigned int nBits, CBlockIndex* pindexPrev, const CBlockHeader& blockFrom, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fPrintProofOfStake=false);
+// Same, from the kernel input's amount and the times of its transaction and block
+bool CheckStakeKernelHash(unsigned int nBits, CBlockIndex* pindexPrev, unsigned int nTimeBlockFrom, unsigned int nTimeTxPrev, CAmount nValueIn, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fPrintProofOfStake=false);
 
 // Check kernel hash target and coinstake signature
 // Sets hashProofOfStake on success return
-bool CheckProofOfStake(CValidationState &state, CBlockIndex* pindexPrev, const CTransactionRef &tx, unsigned int nBits, uint256& hashProofOfStake, uint256& targetProofOfStake);
+// fCheckScript=false skips the kernel input script, for callers that verify it through CheckInputs()
+bool CheckProofOfStake(CValidationState &state, CBlockIndex* pindexPrev, const CTransactionRef &tx, unsigned int nBits, uint256& hashProofOfStake, uint256& targetProofOfStake, bool fCheckScript = true);
 
 // Check whether the coinstake timestamp meets protocol
 bool CheckCoinStakeTimestamp(int64_t nTimeBlock, int64_t nTimeTx);
@@ -36,5 +50,24 @@ bool CheckCoinStakeTimestamp(int64_t nTimeBlock, int64_t nTimeTx);
  * Convenient for searching a kernel
  */
 bool CheckKernel(unsigned int nBits, CBlockIndex *pindexPrev, const CBlockHeader& blockFrom, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTime);
+// Same, from values already known about the kernel input instead of its transaction and block header
+bool CheckKernel(unsigned int nBits, CBlockIndex *pindexPrev, const uint256& hashBlockFrom, unsigned int nTimeBlockFrom, unsigned int nTimeTxPrev, CAmount nValueIn, const COutPoint& prevout, unsigned int nTime);
+
+/** What SearchStakeKernel needs to know about a kernel input */
+struct CStakeKernelInput
+{
+    COutPoint prevout;
+    uint256 hashBlockFrom;
+    unsigned int nTimeTxPrev;
+    CAmount nValue;
+};
+
+/**
+ * Search all timestamps in [nTimeFrom, nTimeTo] for a kernel among vInputs.
+ * Returns the earliest timestamp meeting the target in nTimeRet, and in
+ * nInputRet the first input of vInputs meeting it at that timestamp.
+ * Used only when staking, not during validation
+ */
+bool SearchStakeKernel(unsigned int nBits, CBlockIndex* pindexPrev, const std::vector<CStakeKernelInput>& vInputs, unsigned int nTimeFrom, unsigned int nTimeTo, unsigned int& nTimeRet, size_t& nInputRet);
 
 #endif // PULSAR_KERNEL_H
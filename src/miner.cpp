@@ -8,12 +8,14 @@
 #include <amount.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <fs.h>
 #include <coins.h>
 #include <consensus/consensus.h>
 #include <consensus/tx_verify.h>
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <validation.h>
+#include <minotaurx.h>
 #include <net.h>
 #include <policy/policy.h>
 #include <pow.h>
@@ -29,10 +31,17 @@
 #include <base58.h>
 
 #include <algorithm>
+#include <deque>
+#include <fstream>
 #include <memory>
 #include <queue>
+#include <set>
 #include <utility>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 #include <boost/thread.hpp>
 
 uint64_t nLastBlockTx = 0;
@@ -159,7 +168,9 @@ std::unique_ptr <CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript &s
         if (nSearchTime > nLastCoinStakeSearchTime)
         {
 		int64_t nStart = GetTimeMicros();
-            if (pwallet->CreateCoinStake(*pwallet, pblock->nBits, txCoinStake))
+            // Search the seconds skipped since the last search too, as far back as the block timestamp rules allow
+            int64_t nSearchFrom = std::max(nLastCoinStakeSearchTime + 1, std::max(pindexPrev->GetMedianTimePast()+1, pindexPrev->GetBlockTime() - MAX_FUTURE_BLOCK_TIME));
+            if (pwallet->CreateCoinStake(*pwallet, pblock->nBits, nSearchTime - nSearchFrom + 1, txCoinStake))
             {
                 if (txCoinStake.nTime >= std::max(pindexPrev->GetMedianTimePast()+1, pindexPrev->GetBlockTime() - MAX_FUTURE_BLOCK_TIME))
                 {   // make sure coinstake would meet timestamp protocol
@@ -517,6 +528,137 @@ void IncrementExtraNonce(CBlock *pblock, const CBlockIndex *pindexPrev, unsigned
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
 
+BlockTemplateCache::BlockTemplateCache() : pindexPrev(nullptr), nTransactionsUpdatedLast(0), nStart(0) {}
+
+void BlockTemplateCache::Clear() {
+    pindexPrev = nullptr;
+    for (auto& tmpl : templates)
+        tmpl.reset();
+}
+
+CBlockTemplate* BlockTemplateCache::Get(const CChainParams& chainparams, const POW_TYPE powType, int64_t nMaxAge) {
+    AssertLockHeld(cs_main);
+    if (powType >= NUM_BLOCK_TYPES)
+        throw std::runtime_error("Error: Unrecognised pow type requested");
+
+    if (pindexPrev != chainActive.Tip() ||
+        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > nMaxAge))
+        Clear();
+    if (templates[powType])
+        return templates[powType].get();
+
+    // pulsar: templates of the other algorithms hold the same transactions, only
+    // the pow type bits of nVersion and nBits differ. -blockversion replaces the
+    // whole version on regtest, leave that to CreateNewBlock.
+    if (!(chainparams.MineBlocksOnDemand() && gArgs.IsArgSet("-blockversion"))) {
+        for (const auto& tmpl : templates) {
+            if (!tmpl)
+                continue;
+            if (!IsMinoEnabled(pindexPrev, chainparams.GetConsensus()) && powType != POW_TYPE_CURVEHASH)
+                throw std::runtime_error("Error: Won't attempt to create a non-curvehash block before minotaurx activation");
+            templates[powType].reset(new CBlockTemplate(*tmpl));
+            CBlock& block = templates[powType]->block;
+            block.nVersion = (block.nVersion & ~(0xFF << 16)) | (powType << 16);
+            block.nBits = GetNextTargetRequired(pindexPrev, false, chainparams.GetConsensus(), powType);
+            return templates[powType].get();
+        }
+    }
+
+    // Store the tip and mempool state before CreateNewBlock, to avoid races
+    const CBlockIndex* pindexPrevNew = chainActive.Tip();
+    unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    CScript scriptDummy = CScript() << OP_TRUE;
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(scriptDummy, true, nullptr, nullptr, powType);
+    if (!pblocktemplate)
+        return nullptr;
+
+    // Need to update only after we know CreateNewBlock succeeded
+    pindexPrev = pindexPrevNew;
+    nTransactionsUpdatedLast = nTransactionsUpdated;
+    nStart = GetTime();
+    templates[powType] = std::move(pblocktemplate);
+    return templates[powType].get();
+}
+
+
+namespace {
+/** Wakes the stake minter when the tip changes, and keeps its outcome counters */
+class CStakeMinterNotifier : public CValidationInterface
+{
+public:
+    boost::mutex cs;
+    boost::condition_variable cond;
+    //! Number of tip updates, guarded by cs
+    uint64_t nTipUpdates = 0;
+
+    std::atomic<uint64_t> nSearches{0};
+    std::atomic<uint64_t> nFound{0};
+    std::atomic<uint64_t> nLate{0};
+    std::atomic<uint64_t> nOrphaned{0};
+
+    //! The last MAX_MINTED_TRACKED minted blocks, to notice when one is disconnected again
+    static const size_t MAX_MINTED_TRACKED = 100;
+    CCriticalSection cs_minted;
+    std::set<uint256> setMinted;
+    std::deque<uint256> vMintedOrder;
+
+    void AddMinted(const uint256& hash)
+    {
+        LOCK(cs_minted);
+        if (!setMinted.insert(hash).second)
+            return;
+        vMintedOrder.push_back(hash);
+        if (vMintedOrder.size() > MAX_MINTED_TRACKED) {
+            setMinted.erase(vMintedOrder.front());
+            vMintedOrder.pop_front();
+        }
+    }
+
+    // Wait until the tip changes or nTimeoutMillis passed, whichever is first
+    void Wait(uint64_t& nTipUpdatesSeen, int64_t nTimeoutMillis)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        cond.timed_wait(lock, boost::posix_time::milliseconds(nTimeoutMillis), [&]{ return nTipUpdates != nTipUpdatesSeen; });
+        nTipUpdatesSeen = nTipUpdates;
+    }
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(cs);
+            nTipUpdates++;
+        }
+        cond.notify_all();
+    }
+
+    void BlockDisconnected(const std::shared_ptr<const CBlock> &block) override
+    {
+        LOCK(cs_minted);
+        if (setMinted.count(block->GetHash()))
+            nOrphaned++;
+    }
+};
+
+CStakeMinterNotifier stakeMinterNotifier;
+
+/** Keeps stakeMinterNotifier registered for as long as a stake minter runs */
+class CStakeMinterNotifierRegistration
+{
+public:
+    CStakeMinterNotifierRegistration() { RegisterValidationInterface(&stakeMinterNotifier); }
+    ~CStakeMinterNotifierRegistration() { UnregisterValidationInterface(&stakeMinterNotifier); }
+};
+} // namespace
+
+StakeMinterStats GetStakeMinterStats() {
+    StakeMinterStats stats;
+    stats.nSearches = stakeMinterNotifier.nSearches;
+    stats.nFound = stakeMinterNotifier.nFound;
+    stats.nLate = stakeMinterNotifier.nLate;
+    stats.nOrphaned = stakeMinterNotifier.nOrphaned;
+    return stats;
+}
 
 static bool ProcessBlockFound(const CBlock *pblock, const CChainParams &chainparams) {
     LogPrintf("%s\n", pblock->ToString());
@@ -546,7 +688,7 @@ void PoSMiner(CWallet *pwallet) {
     std::shared_ptr <CReserveScript> coinbaseScript;
     pwallet->GetScriptForMining(coinbaseScript);
 
-    // Compute timeout for pos as sqrt(numUTXO)
+    // Compute the minimum pause between kernel searches for pos as sqrt(numUTXO)
     unsigned int pos_timio;
     {
         std::vector <COutput> vCoins;
@@ -566,6 +708,10 @@ void PoSMiner(CWallet *pwallet) {
         return;
     }
 
+    // pulsar: wake on new tips instead of polling, until the minter stops on any path
+    CStakeMinterNotifierRegistration notifierRegistration;
+    uint64_t nTipUpdatesSeen = 0;
+
     try {
 
         // Throw an error if no script was provided.  This can happen
@@ -575,37 +721,46 @@ void PoSMiner(CWallet *pwallet) {
             throw std::runtime_error("No coinbase script available (mining requires a wallet)");
 
         while (true) {
-            while (pwallet->IsLocked()) {
-                LogPrintf("wallet is locked\n");
+            if (pwallet->IsLocked()) {
+                if (strMintWarning != strMintMessage)
+                    LogPrintf("wallet is locked\n");
                 strMintWarning = strMintMessage;
-                MilliSleep(5000);
+                stakeMinterNotifier.Wait(nTipUpdatesSeen, 5000);
+                continue;
             }
             unsigned int nMiningRequiresPeers = Params().MiningRequiresPeers();
             if (nMiningRequiresPeers > 0) {
-                // Busy-wait for the network to come online so we don't waste time mining
+                // Wait for the network to come online so we don't waste time mining
                 // on an obsolete chain. In regtest mode we expect to fly solo.
-                while (g_connman == nullptr || g_connman->GetNodeCount(CConnman::CONNECTIONS_ALL) < nMiningRequiresPeers || IsInitialBlockDownload())
-                    MilliSleep(5 * 1000);
+                if (g_connman == nullptr || g_connman->GetNodeCount(CConnman::CONNECTIONS_ALL) < nMiningRequiresPeers || IsInitialBlockDownload()) {
+                    stakeMinterNotifier.Wait(nTipUpdatesSeen, 5 * 1000);
+                    continue;
+                }
             }
-            while (GuessVerificationProgress(Params().TxData(), chainActive.Tip()) < 0.996) {
-                LogPrintf("Minter thread sleeps while sync at %f\n", GuessVerificationProgress(Params().TxData(), chainActive.Tip()));
+            if (GuessVerificationProgress(Params().TxData(), chainActive.Tip()) < 0.996) {
+                if (strMintWarning != strMintSyncMessage)
+                    LogPrintf("Minter thread sleeps while sync at %f\n", GuessVerificationProgress(Params().TxData(), chainActive.Tip()));
                 strMintWarning = strMintSyncMessage;
-                MilliSleep(10000);
+                stakeMinterNotifier.Wait(nTipUpdatesSeen, 10000);
+                continue;
             }
 
             strMintWarning = strMintEmpty;
 
-	    //ADDED
-
             //
-            // Create new block
+            // Search for a kernel, CreateNewBlock only assembles the block if one is found
             //
             CBlockIndex *pindexPrev = chainActive.Tip();
             bool fPoSCancel = false;
+            stakeMinterNotifier.nSearches++;
             std::unique_ptr <CBlockTemplate> pblocktemplate(BlockAssembler(Params()).CreateNewBlock(coinbaseScript->reserveScript, true, pwallet, &fPoSCancel, POW_TYPE_CURVEHASH));
             if (!pblocktemplate.get()) {
                 if (fPoSCancel == true) {
-                    MilliSleep(pos_timio);
+                    // Kernels only change with the time in whole seconds, so search
+                    // again at the next second after the pause, or on a new tip
+                    int64_t nNow = GetTimeMillis();
+                    int64_t nNextSecond = (nNow / 1000 + 1) * 1000;
+                    stakeMinterNotifier.Wait(nTipUpdatesSeen, std::max<int64_t>(pos_timio, nNextSecond - nNow));
                     continue;
                 }
                 strMintWarning = strMintBlockMessage;
@@ -623,13 +778,13 @@ void PoSMiner(CWallet *pwallet) {
                     continue;
                 }
                 LogPrintf("PoSMiner : proof-of-stake block found %s\n", pblock->GetHash().ToString());
-                ProcessBlockFound(pblock, Params());
-                // Rest for ~2 minutes after successful block to preserve close quick
-                MilliSleep(60 * 1000 + GetRand(1 * 60 * 1000));
+                stakeMinterNotifier.nFound++;
+                stakeMinterNotifier.AddMinted(pblock->GetHash());
+                if (!ProcessBlockFound(pblock, Params()))
+                    stakeMinterNotifier.nLate++;
             }
-            MilliSleep(pos_timio);
-
-            continue;
+            // Go on from the new tip as soon as it is connected
+            stakeMinterNotifier.Wait(nTipUpdatesSeen, pos_timio);
         }
     }
     catch (boost::thread_interrupted) {
@@ -670,36 +825,184 @@ void MintStake(boost::thread_group &threadGroup) {
 // Internal miner
 //
 
+static CCriticalSection cs_hashrates;
+static std::map<std::string, double> mapHashRates;
+
+void UpdateHashRate(const std::string& strThread, uint64_t nHashes, int64_t nTimeMicros) {
+    if (nTimeMicros <= 0)
+        return;
+    double dHashesPerSec = 1000000.0 * nHashes / nTimeMicros;
+    LogPrint(BCLog::BENCH, "%s: %.1f hash/s\n", strThread, dHashesPerSec);
+
+    LOCK(cs_hashrates);
+    mapHashRates[strThread] = dHashesPerSec;
+}
+
+std::map<std::string, double> GetHashRates() {
+    LOCK(cs_hashrates);
+    return mapHashRates;
+}
+
+static void ClearMinerHashRates() {
+    LOCK(cs_hashrates);
+    for (auto it = mapHashRates.begin(); it != mapHashRates.end(); ) {
+        if (it->first.compare(0, 6, "miner-") == 0)
+            it = mapHashRates.erase(it);
+        else
+            ++it;
+    }
+}
+
 //
-// ScanHash scans nonces looking for a hash with at least some zero bits.
-// The nonce is usually preserved between calls, but periodically or if the
-// nonce is 0xffff0000 or above, the block is rebuilt and nNonce starts over at
-// zero.
+// ScanHash scans nonces looking for a hash that meets the target.
+// The header must have been loaded into the engine with SetScanHeader(), and
+// nonces are hashed from its cached midstate SCAN_BATCH_SIZE at a time.
+// The nonce is usually preserved between calls, but periodically or at the
+// end of the thread's nonce range, the block is rebuilt and nNonce starts over
+// at the start of the range.
 //
-bool static ScanHash(const CBlockHeader *pblock, uint32_t &nNonce, uint256 *phash) {
+bool static ScanHash(CCurveHashEngine& engine, const arith_uint256& hashTarget, uint32_t &nNonce, uint256 *phash) {
+    uint256 hashes[CCurveHashEngine::SCAN_BATCH_SIZE];
+    unsigned int nTried = 0;
     while (true) {
-        nNonce++;
+        // Calculate Pulsar for the next batch of nonces
+        engine.ScanNonces(nNonce + 1, CCurveHashEngine::SCAN_BATCH_SIZE, hashes);
 
-        // Calculate Pulsar for given block and nonce
-        Pulsar(pblock, nNonce, phash);
+        for (const uint256& hash : hashes) {
+            nNonce++;
 
-        // Return the nonce if the hash has at least some zero bits,
-        // caller will check if it has enough to reach the target
-        if (((uint16_t *) phash)[15] == 0)
-            return true;
+            // A zero bits prefilter would drop most solutions of targets
+            // easier than 2^240, such as the testnet and regtest limits
+            if (UintToArith256(hash) <= hashTarget) {
+                *phash = hash;
+                return true;
+            }
+        }
 
         // If nothing found after trying for a while, return -1
-        if ((nNonce & 0xfff) == 0) {
+        nTried += CCurveHashEngine::SCAN_BATCH_SIZE;
+        if (nTried >= 0x1000) {
             return false;
         }
     }
 }
 
+//
+// ScanMinotaurX does the same for MinotaurX headers, with the thread's hasher.
+// Each hash costs a yespower pass, so it returns after far fewer nonces.
+//
+bool static ScanMinotaurX(CMinotaurXHasher& hasher, CBlockHeader *pblock, const arith_uint256& hashTarget, uint32_t &nNonce, uint256 *phash) {
+    unsigned int nTried = 0;
+    while (true) {
+        pblock->nNonce = ++nNonce;
+        *phash = hasher.Hash(BEGIN(pblock->nVersion), END(pblock->nNonce));
+
+        if (UintToArith256(*phash) <= hashTarget)
+            return true;
+
+        if (++nTried >= 0x40)
+            return false;
+    }
+}
+
+#ifdef __linux__
+// Parse a sysfs cpu list such as "0-3,8-11"
+static std::vector<int> ParseCPUList(const std::string& str) {
+    std::vector<int> vCPUs;
+    std::stringstream ss(str);
+    std::string strRange;
+    while (std::getline(ss, strRange, ',')) {
+        size_t nDash = strRange.find('-');
+        int nFirst = atoi(strRange.substr(0, nDash));
+        int nLast = nDash == std::string::npos ? nFirst : atoi(strRange.substr(nDash + 1));
+        for (int nCPU = nFirst; nCPU <= nLast; nCPU++)
+            vCPUs.push_back(nCPU);
+    }
+    return vCPUs;
+}
+#endif
+
+// CPUs for the mining threads, in order. The CPUs of the NUMA nodes are
+// interleaved, so consecutive threads are spread over the nodes.
+static std::vector<int> GetMinerCPUs() {
+    std::vector<std::vector<int>> vNodes;
+#ifdef __linux__
+    try {
+        const fs::path pathNodes("/sys/devices/system/node");
+        if (fs::is_directory(pathNodes)) {
+            for (fs::directory_iterator it(pathNodes); it != fs::directory_iterator(); ++it) {
+                const std::string strName = it->path().filename().string();
+                if (strName.compare(0, 4, "node") != 0 || strName.size() == 4 || strName[4] < '0' || strName[4] > '9')
+                    continue;
+                std::ifstream file((it->path() / "cpulist").string());
+                std::string strList;
+                if (std::getline(file, strList)) {
+                    std::vector<int> vCPUs = ParseCPUList(strList);
+                    if (!vCPUs.empty())
+                        vNodes.push_back(vCPUs);
+                }
+            }
+        }
+    } catch (const fs::filesystem_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+    }
+#endif
+    std::vector<int> vCPUs;
+    if (vNodes.empty()) {
+        for (int nCPU = 0; nCPU < GetNumCores(); nCPU++)
+            vCPUs.push_back(nCPU);
+        return vCPUs;
+    }
+    for (size_t i = 0, nAdded = 1; nAdded > 0; i++) {
+        nAdded = 0;
+        for (const std::vector<int>& vNode : vNodes) {
+            if (i < vNode.size()) {
+                vCPUs.push_back(vNode[i]);
+                nAdded++;
+            }
+        }
+    }
+    return vCPUs;
+}
+
+// With -minerpin, pin the calling mining thread to its own CPU. The thread's
+// CurveHash engine and MinotaurX arena are allocated after this, so they land
+// on the memory of that CPU's NUMA node.
+static void PinMinerThread(int nThread) {
+    if (!gArgs.GetBoolArg("-minerpin", DEFAULT_MINER_PIN))
+        return;
+#ifdef __linux__
+    static const std::vector<int> vCPUs = GetMinerCPUs();
+    if (vCPUs.empty())
+        return;
+    const int nCPU = vCPUs[nThread % vCPUs.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(nCPU, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        LogPrintf("%s: failed to pin mining thread %d to cpu %d\n", __func__, nThread, nCPU);
+#else
+    LogPrintf("%s: -minerpin is only supported on Linux\n", __func__);
+#endif
+}
+
 //void static PulsarMiner(const CChainParams &chainparams, void *parg) {
-void static PulsarMiner(const CChainParams &chainparams, void *parg, const POW_TYPE powType) {
+void static PulsarMiner(const CChainParams &chainparams, void *parg, const POW_TYPE powType, int nThread, int nThreads) {
     LogPrintf("PulsarMiner started\n");
     RenameThread("pulsar-miner");
+    PinMinerThread(nThread);
     CWallet *pwallet = (CWallet *) parg;
+    const std::string strThread = strprintf("miner-%d", nThread);
+    // Each thread mines to its own reserved key, so threads never hash the same
+    // header. The nonce space is split so that every thread scans a template
+    // for the same number of nonces before rebuilding it. The last 0x10000
+    // nonces of a slice are left for the scan call that crosses nNonceEnd;
+    // slices smaller than that end after a single call.
+    const uint32_t nNonceSpan = 0xffff0000 / std::max(nThreads, 1);
+    const uint32_t nNonceStart = nNonceSpan * nThread;
+    const uint32_t nNonceEnd = nNonceSpan > 0x10000 ? nNonceStart + nNonceSpan - 0x10000 : nNonceStart;
+    CCurveHashEngine& engine = GetCurveHashEngine();
+    CMinotaurXHasher* pMinotaurXHasher = powType == POW_TYPE_MINOTAURX ? &GetMinotaurXHasher() : nullptr;
 
     unsigned int nExtraNonce = 0;
 
@@ -759,15 +1062,28 @@ void static PulsarMiner(const CChainParams &chainparams, void *parg, const POW_T
             //
             nStart = GetTime();
             arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
-            nNonce = 0;
+            nNonce = nNonceStart;
+            engine.SetScanHeader(*pblock);
+            int64_t nHashMeterStart = GetTimeMicros();
+            uint32_t nHashMeterNonce = nNonce;
             while (true) {
                 // Check if something found
-                if (ScanHash(pblock, nNonce, &hash)) {
+                bool fFound = pMinotaurXHasher ? ScanMinotaurX(*pMinotaurXHasher, pblock, hashTarget, nNonce, &hash) : ScanHash(engine, hashTarget, nNonce, &hash);
+
+                int64_t nHashMeterNow = GetTimeMicros();
+                if (nHashMeterNow - nHashMeterStart >= 10 * 1000000) {
+                    UpdateHashRate(strThread, nNonce - nHashMeterNonce, nHashMeterNow - nHashMeterStart);
+                    nHashMeterStart = nHashMeterNow;
+                    nHashMeterNonce = nNonce;
+                }
+
+                if (fFound) {
                     if (UintToArith256(hash) <= hashTarget) {
                         // Found a solution
                         pblock->nNonce = nNonce;
 			//hash = pblock->ComputePoWHash();
-                        GetPoWHash(pblock, &hash);
+                        if (!pMinotaurXHasher)
+                            GetPoWHash(pblock, &hash);
 //                        GetPoWHash();
 
 //                        LOCK2(cs_main, pwallet->cs_wallet);
@@ -794,7 +1110,7 @@ void static PulsarMiner(const CChainParams &chainparams, void *parg, const POW_T
                 // Regtest mode doesn't require peers
                 if ((g_connman == nullptr || g_connman->GetNodeCount(CConnman::CONNECTIONS_ALL) == 0) && chainparams.MiningRequiresPeers())
                     break;
-                if (nNonce >= 0xffff0000)
+                if (nNonce >= nNonceEnd)
                     break;
                 if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60)
                     break;
@@ -809,6 +1125,8 @@ void static PulsarMiner(const CChainParams &chainparams, void *parg, const POW_T
                     // Changing pblock->nTime can change work required on testnet:
                     hashTarget.SetCompact(pblock->nBits);
                 }
+                // nTime and nBits are part of the midstate
+                engine.SetScanHeader(*pblock);
             }
         }
         throw boost::thread_interrupted();
@@ -833,6 +1151,7 @@ void GeneratePulsar(bool fGenerate, int nThreads, const CChainParams &chainparam
         minerThreads->interrupt_all();
         delete minerThreads;
         minerThreads = NULL;
+        ClearMinerHashRates();
     }
 
     if (nThreads == 0 || !fGenerate)
@@ -859,6 +1178,58 @@ void GeneratePulsar(bool fGenerate, int nThreads, const CChainParams &chainparam
 
     if (!vpwallets.empty()) {
         for (int i = 0; i < nThreads; i++)
-            minerThreads->create_thread(boost::bind(&PulsarMiner, boost::cref(chainparams), vpwallets[0], powType));
+            minerThreads->create_thread(boost::bind(&PulsarMiner, boost::cref(chainparams), vpwallets[0], powType, i, nThreads));
+    }
+}
+
+static void MinerBenchThread(const POW_TYPE powType, int nThread, int64_t nSeconds, std::atomic<uint64_t>* pnHashes, std::atomic<int64_t>* pnMicros) {
+    RenameThread("pulsar-minerbench");
+    PinMinerThread(nThread);
+
+    CBlockHeader header;
+    header.nVersion = powType << 16;
+    header.hashPrevBlock = GetRandHash();
+    header.hashMerkleRoot = GetRandHash();
+    header.nTime = GetTime();
+    header.nBits = 0;
+    const arith_uint256 hashTarget; // zero, nothing is ever found
+    uint32_t nNonce = 0;
+    uint256 hash;
+
+    // Allocate the hashers before the clock starts
+    CCurveHashEngine& engine = GetCurveHashEngine();
+    engine.SetScanHeader(header);
+    CMinotaurXHasher* pMinotaurXHasher = powType == POW_TYPE_MINOTAURX ? &GetMinotaurXHasher() : nullptr;
+    if (pMinotaurXHasher)
+        pMinotaurXHasher->Hash(BEGIN(header.nVersion), END(header.nNonce));
+
+    const int64_t nStart = GetTimeMicros();
+    const int64_t nEnd = nStart + nSeconds * 1000000;
+    while (GetTimeMicros() < nEnd) {
+        if (pMinotaurXHasher)
+            ScanMinotaurX(*pMinotaurXHasher, &header, hashTarget, nNonce, &hash);
+        else
+            ScanHash(engine, hashTarget, nNonce, &hash);
+    }
+    *pnHashes += nNonce;
+    *pnMicros += GetTimeMicros() - nStart;
+}
+
+void MinerBench(int nThreads, int64_t nSeconds) {
+    if (nThreads <= 0)
+        nThreads = GetNumCores();
+    for (unsigned int i = 0; i < NUM_BLOCK_TYPES; i++) {
+        const POW_TYPE powType = (POW_TYPE)i;
+        std::atomic<uint64_t> nHashes(0);
+        std::atomic<int64_t> nMicros(0);
+        boost::thread_group threads;
+        for (int nThread = 0; nThread < nThreads; nThread++)
+            threads.create_thread(boost::bind(&MinerBenchThread, powType, nThread, nSeconds, &nHashes, &nMicros));
+        threads.join_all();
+
+        // Sum of the per-thread rates, from the mean time a thread hashed for
+        const double dHashesPerSec = nMicros ? nHashes * 1e6 * nThreads / nMicros : 0;
+        LogPrintf("MinerBench %s: %.2f H/s with %d threads (%.2f H/s per thread)\n",
+            POW_TYPE_NAMES[i], dHashesPerSec, nThreads, dHashesPerSec / nThreads);
     }
 }
@@ -10,7 +10,9 @@
 #include <txmempool.h>
 
 #include <stdint.h>
+#include <map>
 #include <memory>
+#include <string>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <pulsar.h>
@@ -24,6 +26,10 @@ namespace Consensus { struct Params; };
 
 static const bool DEFAULT_GENERATE = false;
 static const int DEFAULT_GENERATE_THREADS = 1;
+/** Default for -minerpin */
+static const bool DEFAULT_MINER_PIN = false;
+/** Seconds -minerbench hashes with each algorithm */
+static const int64_t MINER_BENCH_SECONDS = 10;
 
 static const bool DEFAULT_PRINTPRIORITY = false;
 
@@ -195,6 +201,35 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx);
 };
 
+/**
+ * getblocktemplate's templates, one per proof-of-work algorithm. For the same
+ * tip and mempool they only differ in their header, so the transactions
+ * selected for one algorithm are reused for the others instead of running
+ * CreateNewBlock again. Callers hold cs_main.
+ */
+class BlockTemplateCache
+{
+private:
+    //! Tip the cached transactions were selected on, nullptr if there are none
+    const CBlockIndex* pindexPrev;
+    unsigned int nTransactionsUpdatedLast;
+    int64_t nStart;
+    std::unique_ptr<CBlockTemplate> templates[NUM_BLOCK_TYPES];
+
+public:
+    BlockTemplateCache();
+
+    /** Template for powType on the active tip. Transactions are selected again
+     *  when the tip changes, or when the mempool changed and the selection is
+     *  older than nMaxAge seconds. Returns nullptr if no template could be made. */
+    CBlockTemplate* Get(const CChainParams& chainparams, const POW_TYPE powType, int64_t nMaxAge = 5);
+    /** Forget all templates, so the next Get() selects transactions again */
+    void Clear();
+
+    const CBlockIndex* GetPrevBlock() const { return pindexPrev; }
+    unsigned int GetTransactionsUpdated() const { return nTransactionsUpdatedLast; }
+};
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 //int64_t UpdateTime(CBlockHeader* pblock, const POW_TYPE powType);
@@ -205,7 +240,24 @@ namespace boost {
 } // namespace boost
 void MintStake(boost::thread_group& threadGroup);
 
+/** Outcome counters of the stake minter */
+struct StakeMinterStats {
+    uint64_t nSearches;  //!< Kernel searches
+    uint64_t nFound;     //!< Proof-of-stake blocks minted
+    uint64_t nLate;      //!< Minted blocks that were stale or rejected when submitted
+    uint64_t nOrphaned;  //!< Minted blocks disconnected from the active chain afterwards
+};
+StakeMinterStats GetStakeMinterStats();
+
 /** Run the miner threads */
 void GeneratePulsar(bool fGenerate, int nThreads, const CChainParams& chainparams);
 
+/** Measure the hash rate of each mining algorithm with nThreads threads (all cores if 0) for nSeconds each */
+void MinerBench(int nThreads, int64_t nSeconds);
+
+/** Record that a mining thread tried nHashes nonces in nTimeMicros */
+void UpdateHashRate(const std::string& strThread, uint64_t nHashes, int64_t nTimeMicros);
+/** Last measured hashes per second of each mining thread, by thread name */
+std::map<std::string, double> GetHashRates();
+
 #endif // BITCOIN_MINER_H
@@ -0,0 +1,119 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <minotaurx.h>
+#include <crypto/minotaurx/minotaur.h>
+
+#include <atomic>
+
+#include <assert.h>
+
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+
+static std::atomic<size_t> nMinotaurXHashers(0);
+static std::atomic<size_t> nMinotaurXHugePageHashers(0);
+static std::atomic<size_t> nMinotaurXBytes(0);
+
+CMinotaurXHasher::CMinotaurXHasher() : fHugePages(false)
+{
+    garden = new TortureGarden;
+    PlantTortureGarden(garden);
+    yespower_init_local(&local);
+
+    // Let a first yespower pass size the arena, so it is in place before any
+    // real hash and can be moved to huge pages
+    static const unsigned char vchWarmUp[64] = {};
+    yespower_binary_t warmup;
+    assert(yespower(&local, vchWarmUp, sizeof(vchWarmUp), &yespower_params, &warmup) == 0);
+    MapHugePages();
+
+    nMinotaurXHashers++;
+    if (fHugePages)
+        nMinotaurXHugePageHashers++;
+    nMinotaurXBytes += DynamicMemoryUsage();
+}
+
+CMinotaurXHasher::~CMinotaurXHasher()
+{
+    nMinotaurXBytes -= DynamicMemoryUsage();
+    if (fHugePages)
+        nMinotaurXHugePageHashers--;
+    nMinotaurXHashers--;
+
+    yespower_free_local(&local);
+    delete garden;
+}
+
+#if defined(MAP_ANON) && (defined(MAP_HUGETLB) || defined(MADV_HUGEPAGE))
+void CMinotaurXHasher::MapHugePages()
+{
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    const size_t nSize = (local.aligned_size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    void* base = MAP_FAILED;
+    size_t nBaseSize = nSize;
+    unsigned char* aligned = nullptr;
+
+#ifdef MAP_HUGETLB
+    // Reserved huge pages, when the administrator set some aside
+    base = mmap(nullptr, nSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED)
+        aligned = (unsigned char*)base;
+#endif
+#ifdef MADV_HUGEPAGE
+    if (base == MAP_FAILED) {
+        // Transparent huge pages, over-allocating so that an aligned arena fits
+        nBaseSize = nSize + HUGE_PAGE_SIZE;
+        base = mmap(nullptr, nBaseSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+        if (base != MAP_FAILED) {
+            aligned = (unsigned char*)(((uintptr_t)base + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+            if (madvise(aligned, nSize, MADV_HUGEPAGE) != 0) {
+                munmap(base, nBaseSize);
+                base = MAP_FAILED;
+            }
+        }
+    }
+#endif
+    if (base == MAP_FAILED)
+        return;
+
+    // Hand the mapping to yespower, which munmap()s base_size bytes from base when freeing it
+    yespower_free_local(&local);
+    local.base = base;
+    local.aligned = aligned;
+    local.base_size = nBaseSize;
+    local.aligned_size = nSize;
+    fHugePages = true;
+}
+#else
+void CMinotaurXHasher::MapHugePages()
+{
+}
+#endif
+
+uint256 CMinotaurXHasher::Hash(const char* pbegin, const char* pend)
+{
+    return Minotaur(pbegin, pend, true, &local, garden);
+}
+
+size_t CMinotaurXHasher::DynamicMemoryUsage() const
+{
+    return local.base_size + sizeof(TortureGarden);
+}
+
+CMinotaurXHasher& GetMinotaurXHasher()
+{
+    static thread_local CMinotaurXHasher hasher;
+    return hasher;
+}
+
+MinotaurXMemoryStats GetMinotaurXMemoryStats()
+{
+    MinotaurXMemoryStats stats;
+    stats.nHashers = nMinotaurXHashers;
+    stats.nHugePageHashers = nMinotaurXHugePageHashers;
+    stats.nBytes = nMinotaurXBytes;
+    return stats;
+}
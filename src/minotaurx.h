@@ -0,0 +1,62 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PULSAR_MINOTAURX_H
+#define PULSAR_MINOTAURX_H
+
+#include <uint256.h>
+#include <crypto/minotaurx/yespower/yespower.h>
+
+#include <stddef.h>
+
+struct TortureGarden;
+
+/**
+ * MinotaurX hasher.
+ * Owns the yespower arena and the TortureGarden used by the memory-hard gate,
+ * so they are allocated once per hasher instead of depending on the hidden
+ * thread-local storage of yespower_tls(). Where the system allows it the arena
+ * is backed by huge pages. A hasher is not thread safe; every validation or
+ * mining thread uses its own through GetMinotaurXHasher().
+ */
+class CMinotaurXHasher
+{
+public:
+    CMinotaurXHasher();
+    ~CMinotaurXHasher();
+
+    CMinotaurXHasher(const CMinotaurXHasher&) = delete;
+    CMinotaurXHasher& operator=(const CMinotaurXHasher&) = delete;
+
+    /** Compute the MinotaurX hash of [pbegin, pend) */
+    uint256 Hash(const char* pbegin, const char* pend);
+
+    /** Bytes held by this hasher, arena included */
+    size_t DynamicMemoryUsage() const;
+
+    /** Whether the arena is backed by huge pages */
+    bool HasHugePages() const { return fHugePages; }
+
+private:
+    yespower_local_t local;
+    TortureGarden* garden;
+    bool fHugePages;
+
+    /** Move the arena sized by the first yespower pass to huge pages */
+    void MapHugePages();
+};
+
+/** Return the calling thread's MinotaurX hasher, creating it on first use */
+CMinotaurXHasher& GetMinotaurXHasher();
+
+/** Memory held by all live MinotaurX hashers */
+struct MinotaurXMemoryStats
+{
+    size_t nHashers;
+    size_t nHugePageHashers;
+    size_t nBytes;
+};
+MinotaurXMemoryStats GetMinotaurXMemoryStats();
+
+#endif // PULSAR_MINOTAURX_H
@@ -30,6 +30,7 @@
 #include <utilmoneystr.h>
 #include <utilstrencodings.h>
 
+#include <deque>
 #include <memory>
 
 #include <checkpointsync.h>
@@ -121,12 +122,21 @@ namespace {
     };
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight;
 
-    /** Pulsarcoin: blocks that are waiting to be processed, the key points to previous CBlockIndex entry */
+    /** Pulsarcoin: blocks that are waiting to be processed, the key points to previous CBlockIndex entry. Protected by cs_main. */
     struct WaitElement {
         std::shared_ptr<CBlock> pblock;
-            int64_t time;
+        int64_t time;
+        NodeId fromPeer;
+        size_t nSize;
+        std::multimap<int64_t, CBlockIndex*>::iterator itTime;
     };
     std::map<CBlockIndex*, WaitElement> mapBlocksWait;
+    /** Keys of mapBlocksWait ordered by arrival time, used for expiry and eviction. */
+    std::multimap<int64_t, CBlockIndex*> mapBlocksWaitByTime;
+    /** Keys of mapBlocksWait whose previous block was accepted, before or after they arrived. */
+    std::deque<CBlockIndex*> vBlocksWaitReady;
+    /** Total serialized size of the blocks in mapBlocksWait. */
+    size_t nBlocksWaitBytes = 0;
 
     /** Stack of nodes which we have set to announce using compact blocks */
     std::list<NodeId> lNodesAnnouncingHeaderAndIDs;
@@ -250,6 +260,12 @@ struct CNodeState {
     //! Time of last new block announcement
     int64_t m_last_block_announcement;
 
+    //! Number and total size of this peer's blocks in mapBlocksWait
+    int nBlocksWait;
+    size_t nBlocksWaitBytes;
+    //! How many of this peer's blocks were dropped from mapBlocksWait without being processed
+    int nBlocksWaitEvicted;
+
     CNodeState(CAddress addrIn, std::string addrNameIn) : address(addrIn), name(addrNameIn) {
         fCurrentlyConnected = false;
         nMisbehavior = 0;
@@ -274,6 +290,9 @@ struct CNodeState {
         fSupportsDesiredCmpctVersion = false;
         m_chain_sync = { 0, nullptr, false, false };
         m_last_block_announcement = 0;
+        nBlocksWait = 0;
+        nBlocksWaitBytes = 0;
+        nBlocksWaitEvicted = 0;
     }
 };
 
@@ -345,6 +364,100 @@ bool MarkBlockAsReceived(const uint256& hash) {
     return false;
 }
 
+// Requires cs_main.
+// Pulsarcoin: remove the block waiting on pindexPrev from mapBlocksWait.
+// If fEvicted, the block is dropped without being processed and is no longer considered in flight.
+void EraseBlockWait(std::map<CBlockIndex*, WaitElement>::iterator it, bool fEvicted)
+{
+    CNodeState *state = State(it->second.fromPeer);
+    if (state != nullptr) {
+        state->nBlocksWait--;
+        state->nBlocksWaitBytes -= it->second.nSize;
+        state->nBlocksWaitEvicted += fEvicted;
+    }
+    if (fEvicted)
+        MarkBlockAsReceived(it->second.pblock->GetHash());
+    nBlocksWaitBytes -= it->second.nSize;
+    mapBlocksWaitByTime.erase(it->second.itTime);
+    mapBlocksWait.erase(it);
+}
+
+// Requires cs_main.
+// Pulsarcoin: store a block until its previous block has been accepted. Replaces any
+// block already waiting on the same previous block. Returns false if the peer's quota is used up.
+bool AddBlockWait(CBlockIndex* pindexPrev, const std::shared_ptr<CBlock>& pblock, NodeId nodeid, int64_t nTimeNow)
+{
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+    const size_t nSize = ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION);
+    const bool fReady = pindexPrev->IsValid(BLOCK_VALID_TRANSACTIONS);
+
+    std::map<CBlockIndex*, WaitElement>::iterator it = mapBlocksWait.find(pindexPrev);
+    if (it != mapBlocksWait.end())
+        EraseBlockWait(it, it->second.pblock->GetHash() != pblock->GetHash());
+
+    // Blocks that can be processed right away never count against the quota
+    if (!fReady && state->nBlocksWaitBytes + nSize > MAX_BLOCKS_WAIT_SIZE_PER_PEER) {
+        state->nBlocksWaitEvicted++;
+        MarkBlockAsReceived(pblock->GetHash());
+        return false;
+    }
+
+    WaitElement& we = mapBlocksWait[pindexPrev];
+    we.pblock = pblock;
+    we.time = nTimeNow;
+    we.fromPeer = nodeid;
+    we.nSize = nSize;
+    we.itTime = mapBlocksWaitByTime.emplace(nTimeNow, pindexPrev);
+    nBlocksWaitBytes += nSize;
+    state->nBlocksWait++;
+    state->nBlocksWaitBytes += nSize;
+    if (fReady)
+        vBlocksWaitReady.push_back(pindexPrev);
+
+    // Drop the oldest blocks once over the total budget, keeping the new one
+    while (nBlocksWaitBytes > MAX_BLOCKS_WAIT_SIZE && mapBlocksWaitByTime.begin()->second != pindexPrev)
+        EraseBlockWait(mapBlocksWait.find(mapBlocksWaitByTime.begin()->second), true);
+    return true;
+}
+
+// Requires cs_main.
+// Pulsarcoin: remove blocks that were not connected in BLOCKS_WAIT_EXPIRE_TIME seconds
+void ExpireBlocksWait(int64_t nTimeNow)
+{
+    while (!mapBlocksWaitByTime.empty() && nTimeNow > mapBlocksWaitByTime.begin()->first + BLOCKS_WAIT_EXPIRE_TIME)
+        EraseBlockWait(mapBlocksWait.find(mapBlocksWaitByTime.begin()->second), true);
+}
+
+// Requires cs_main.
+// Pulsarcoin: select the next block from mapBlocksWait whose previous block has been accepted.
+// Follows the chain from pindexLastAccepted first, then blocks whose previous block was
+// accepted in any other way, then blocks on top of the active tip; never scans the whole map.
+std::map<CBlockIndex*, WaitElement>::iterator SelectBlockWait(CBlockIndex* pindexLastAccepted)
+{
+    std::map<CBlockIndex*, WaitElement>::iterator it;
+    if (pindexLastAccepted != nullptr) {
+        it = mapBlocksWait.find(pindexLastAccepted);
+        if (it != mapBlocksWait.end())
+            return it;
+    }
+    while (!vBlocksWaitReady.empty()) {
+        it = mapBlocksWait.find(vBlocksWaitReady.front());
+        vBlocksWaitReady.pop_front();
+        if (it == mapBlocksWait.end())
+            continue;   // already processed or evicted
+        if (it->first->nStatus & BLOCK_FAILED_MASK) {
+            EraseBlockWait(it, true);  // prev block was rejected
+            continue;
+        }
+        return it;
+    }
+    it = mapBlocksWait.find(chainActive.Tip());
+    if (it != mapBlocksWait.end())
+        return it;
+    return mapBlocksWait.end();
+}
+
 // Requires cs_main.
 // returns false, still setting pit, if the block was already in flight from the same peer
 // pit will only be valid as long as the same cs_main lock is being held
@@ -633,6 +746,9 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
     stats.nMisbehavior = state->nMisbehavior;
     stats.nSyncHeight = state->pindexBestKnownBlock ? state->pindexBestKnownBlock->nHeight : -1;
     stats.nCommonHeight = state->pindexLastCommonBlock ? state->pindexLastCommonBlock->nHeight : -1;
+    stats.nBlocksWait = state->nBlocksWait;
+    stats.nBlocksWaitBytes = state->nBlocksWaitBytes;
+    stats.nBlocksWaitEvicted = state->nBlocksWaitEvicted;
     for (const QueuedBlock& queue : state->vBlocksInFlight) {
         if (queue.pindex)
             stats.vHeightInFlight.push_back(queue.pindex->nHeight);
@@ -640,6 +756,15 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
     return true;
 }
 
+bool IsBlockWaiting(const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (pindex->pprev == nullptr)
+        return false;
+    std::map<CBlockIndex*, WaitElement>::const_iterator it = mapBlocksWait.find(pindex->pprev);
+    return it != mapBlocksWait.end() && it->second.pblock->GetHash() == pindex->GetBlockHash();
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // mapOrphanTransactions
@@ -933,6 +1058,14 @@ void PeerLogicValidation::UpdatedBlockTip(const CBlockIndex *pindexNew, const CB
     nTimeBestReceived = GetTime();
 }
 
+// Pulsarcoin: a block waiting on pindex can be processed now, whether pindex came in
+// as a full block, a compact block or from another peer, on any branch
+void PeerLogicValidation::BlockTransactionsReceived(const CBlockIndex *pindex) {
+    LOCK(cs_main);
+    if (mapBlocksWait.count(const_cast<CBlockIndex*>(pindex)))
+        vBlocksWaitReady.push_back(const_cast<CBlockIndex*>(pindex));
+}
+
 void PeerLogicValidation::BlockChecked(const CBlock& block, const CValidationState& state) {
     LOCK(cs_main);
 
@@ -1520,6 +1653,64 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
     return true;
 }
 
+// Pulsarcoin: accept as many blocks as we possibly can from mapBlocksWait, crediting
+// the peers they came from
+static void ProcessBlocksWait(const CChainParams& chainparams, CConnman* connman)
+{
+    static CBlockIndex* pindexLastAccepted = nullptr;
+    {
+        LOCK(cs_main);
+        if (pindexLastAccepted == nullptr)
+            pindexLastAccepted = chainActive.Tip();
+    }
+
+    while (true) {
+        bool forceProcessing = false;
+        std::shared_ptr<CBlock> pblock;
+        NodeId nodeFrom;
+
+        {
+        LOCK(cs_main);
+        std::map<CBlockIndex*, WaitElement>::iterator it = SelectBlockWait(pindexLastAccepted);
+        if (it == mapBlocksWait.end())
+            break;
+        pblock = it->second.pblock;
+        nodeFrom = it->second.fromPeer;
+        EraseBlockWait(it, false);
+
+        const uint256 hash(pblock->GetHash());
+
+        // Also always process if we requested the block explicitly, as we may
+        // need it even though it is not a candidate for a new best tip.
+        forceProcessing |= MarkBlockAsReceived(hash);
+        // mapBlockSource is only used for sending reject messages and DoS scores,
+        // so the race between here and cs_main in ProcessNewBlock is fine.
+        mapBlockSource.emplace(hash, std::make_pair(nodeFrom, true));
+        }   // LOCK(cs_main);
+
+        bool fNewBlock = false;
+        bool fPoSDuplicate = false;
+        ProcessNewBlock(chainparams, pblock, forceProcessing, &fNewBlock, &pindexLastAccepted, &fPoSDuplicate);
+        if (fNewBlock) {
+            connman->ForNode(nodeFrom, [](CNode* pnode) {
+                pnode->nLastBlockTime = GetTime();
+                return true;
+            });
+        } else {
+            LOCK(cs_main);
+            mapBlockSource.erase(pblock->GetHash());
+        }
+        if (fPoSDuplicate)
+        {
+            LOCK(cs_main);
+            connman->ForNode(nodeFrom, [](CNode* pnode) {
+                mapPoSTemperature[pnode->addr] += 100;
+                return true;
+            });
+        }
+    }
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
@@ -2608,6 +2799,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 LOCK(cs_main);
                 mapBlockSource.erase(pblock->GetHash());
             }
+            {
             LOCK(cs_main); // hold cs_main for CBlockIndex::IsValid()
             if (pindex->IsValid(BLOCK_VALID_TRANSACTIONS)) {
                 // Clear download state for this block, which is in
@@ -2616,6 +2808,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 // can't be used to interfere with block relay.
                 MarkBlockAsReceived(pblock->GetHash());
             }
+            }
+            // Pulsarcoin: blocks waiting on this one can follow it
+            ProcessBlocksWait(chainparams, connman);
         }
 
     }
@@ -2692,6 +2887,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 LOCK(cs_main);
                 mapBlockSource.erase(pblock->GetHash());
             }
+            // Pulsarcoin: blocks waiting on this one can follow it
+            ProcessBlocksWait(chainparams, connman);
         }
     }
 
@@ -2708,22 +2905,36 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return error("headers message size = %u", nCount);
         }
         headers.resize(nCount);
-        {
-        LOCK(cs_main);
-        int32_t& nPoSTemperature = mapPoSTemperature[pfrom->addr];
-        int nTmpPoSTemperature = nPoSTemperature;
         for (unsigned int n = 0; n < nCount; n++) {
             vRecv >> headers[n];
             ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
             ReadCompactSize(vRecv); // needed for vchBlockSig.
+        }
 
+        // Check the proof of work of the batch in parallel before taking cs_main.
+        // The nFlags workaround below needs it for PoW headers with a zero nonce;
+        // outside initial block download AcceptBlockHeader checks every PoW header,
+        // and will find the verified ones remembered.
+        bool fCheckAllPoW = !IsInitialBlockDownload();
+        std::vector<bool> vCheckPoW(nCount), vPoWValid;
+        for (unsigned int n = 0; n < nCount; n++) {
+            bool fPoS = headers[n].nFlags & CBlockIndex::BLOCK_PROOF_OF_STAKE;
+            vCheckPoW[n] = !fPoS && (fCheckAllPoW || headers[n].nNonce == 0);
+        }
+        CheckHeadersProofOfWork(headers, vCheckPoW, chainparams.GetConsensus(), vPoWValid);
+
+        {
+        LOCK(cs_main);
+        int32_t& nPoSTemperature = mapPoSTemperature[pfrom->addr];
+        int nTmpPoSTemperature = nPoSTemperature;
+        for (unsigned int n = 0; n < nCount; n++) {
             // Pulsarcoin: quick check to see if we should ban peers for PoS spam
             // note: at this point we don't know if PoW headers are valid - we just assume they are
             // so we need to update pfrom->nPoSTemperature once we actualy check them
             bool fPoS = headers[n].nFlags & CBlockIndex::BLOCK_PROOF_OF_STAKE;
 
             // workaround to fix invalid nFlags for PoS
-            if (!fPoS && (headers[n].nNonce == 0) && !CheckProofOfWork(&headers[n], chainparams.GetConsensus())) {
+            if (!fPoS && (headers[n].nNonce == 0) && !vPoWValid[n]) {
             	fPoS = CBlockIndex::BLOCK_PROOF_OF_STAKE;
             	headers[n].nFlags |= CBlockIndex::BLOCK_PROOF_OF_STAKE;
             }
@@ -2789,90 +3000,12 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 }
             }
             // Pulsarcoin: store in memory until we can connect it to some chain
-            WaitElement we; we.pblock = pblock2; we.time = nTimeNow;
-            mapBlocksWait[miPrev->second] = we;
+            ExpireBlocksWait(nTimeNow);
+            if (!AddBlockWait(miPrev->second, pblock2, pfrom->GetId(), nTimeNow))
+                LogPrint(BCLog::NET, "peer=%d exceeded its waiting blocks quota, dropped block %s\n", pfrom->GetId(), hash2.ToString());
         }
 
-        static CBlockIndex* pindexLastAccepted = nullptr;
-        if (pindexLastAccepted == nullptr)
-            pindexLastAccepted = chainActive.Tip();
-        bool fContinue = true;
-
-        // Pulsarcoin: accept as many blocks as we possibly can from mapBlocksWait
-        while (fContinue) {
-            fContinue = false;
-            bool fSelected = false;
-            bool forceProcessing = false;
-            CBlockIndex* pindexPrev;
-            std::shared_ptr<CBlock> pblock;
-
-            {
-            LOCK(cs_main);
-            // Pulsarcoin: try to select next block in a constant time
-            std::map<CBlockIndex*, WaitElement>::iterator it = mapBlocksWait.find(pindexLastAccepted);
-            if (it != mapBlocksWait.end() && pindexLastAccepted != nullptr) {
-                pindexPrev = it->first;
-                pblock = it->second.pblock;
-                mapBlocksWait.erase(pindexPrev);
-                fContinue = true;
-                fSelected = true;
-            } else
-            // otherwise: try to scan for it
-            for (auto& pair : mapBlocksWait) {
-                pindexPrev = pair.first;
-                pblock = pair.second.pblock;
-                const uint256 hash(pblock->GetHash());
-                // remove blocks that were not connected in 60 seconds
-                if (nTimeNow > pair.second.time + 60) {
-                    mapBlocksWait.erase(pindexPrev);
-                    fContinue = true;
-                    MarkBlockAsReceived(hash);
-                    break;
-                }
-                if (!pindexPrev->IsValid(BLOCK_VALID_TRANSACTIONS)) {
-                    if (pindexPrev->nStatus & BLOCK_FAILED_MASK) {
-                        mapBlocksWait.erase(pindexPrev);  // prev block was rejected
-                        fContinue = true;
-                        MarkBlockAsReceived(hash);
-                        break;
-                    }
-                    continue;   // prev block was not (yet) accepted on disk, skip to next one
-                }
-
-                mapBlocksWait.erase(pindexPrev);
-                fContinue = true;
-                fSelected = true;
-                break;
-            }
-            if (!fSelected)
-                continue;
-
-            const uint256 hash(pblock->GetHash());
-
-            // Also always process if we requested the block explicitly, as we may
-            // need it even though it is not a candidate for a new best tip.
-            forceProcessing |= MarkBlockAsReceived(hash);
-            // mapBlockSource is only used for sending reject messages and DoS scores,
-            // so the race between here and cs_main in ProcessNewBlock is fine.
-            mapBlockSource.emplace(hash, std::make_pair(pfrom->GetId(), true));
-            }   // LOCK(cs_main);
-
-            bool fNewBlock = false;
-            bool fPoSDuplicate = false;
-            ProcessNewBlock(chainparams, pblock, forceProcessing, &fNewBlock, &pindexLastAccepted, &fPoSDuplicate);
-            if (fNewBlock) {
-                pfrom->nLastBlockTime = GetTime();
-            } else {
-                LOCK(cs_main);
-                mapBlockSource.erase(pblock->GetHash());
-            }
-            if (fPoSDuplicate)
-            {
-                LOCK(cs_main);
-                int32_t& nPoSTemperature = mapPoSTemperature[pfrom->addr];
-                nPoSTemperature += 100;
-            }
-        }
+        ProcessBlocksWait(chainparams, connman);
     }
 
 
@@ -34,6 +34,12 @@ static constexpr int64_t STALE_CHECK_INTERVAL = 10 * 60; // 10 minutes
 static constexpr int64_t EXTRA_PEER_CHECK_INTERVAL = 45;
 /** Minimum time an outbound-peer-eviction candidate must be connected for, in order to evict, in seconds */
 static constexpr int64_t MINIMUM_CONNECT_TIME = 30;
+/** Pulsarcoin: time after which a block still waiting for its previous block is dropped, in seconds */
+static constexpr int64_t BLOCKS_WAIT_EXPIRE_TIME = 60;
+/** Pulsarcoin: maximum total size of blocks waiting for their previous block */
+static constexpr size_t MAX_BLOCKS_WAIT_SIZE = 64 * 1000 * 1000;
+/** Pulsarcoin: maximum size of waiting blocks a single peer may hold */
+static constexpr size_t MAX_BLOCKS_WAIT_SIZE_PER_PEER = 16 * 1000 * 1000;
 
 class PeerLogicValidation : public CValidationInterface, public NetEventsInterface {
 private:
@@ -46,6 +52,7 @@ public:
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
     void BlockChecked(const CBlock& block, const CValidationState& state) override;
     void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
+    void BlockTransactionsReceived(const CBlockIndex *pindex) override;
 
 
     void InitializeNode(CNode* pnode) override;
@@ -74,10 +81,15 @@ struct CNodeStateStats {
     int nSyncHeight;
     int nCommonHeight;
     std::vector<int> vHeightInFlight;
+    int nBlocksWait;
+    size_t nBlocksWaitBytes;
+    int nBlocksWaitEvicted;
 };
 
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
+/** Pulsarcoin: whether the block is received and waiting for its previous block to be accepted. Requires cs_main. */
+bool IsBlockWaiting(const CBlockIndex* pindex);
 /** Increase a node's misbehavior score. */
 void Misbehaving(NodeId nodeid, int howmuch);
 
@@ -0,0 +1,180 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <networkstats.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <rpc/blockchain.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <vector>
+
+const std::string NETSTATS_STREAM_NAMES[NETSTATS_STREAMS] = {"pos", "curvehash", "minotaurx"};
+
+std::unique_ptr<CNetworkStatsEstimator> g_networkstats;
+
+static int GetStream(const CBlockIndex* pindex)
+{
+    if (pindex->IsProofOfStake())
+        return NETSTATS_POS;
+    return pindex->GetPoWType() == POW_TYPE_MINOTAURX ? NETSTATS_MINOTAURX : NETSTATS_CURVEHASH;
+}
+
+// Last block of the stream at or below pindex
+static const CBlockIndex* FindLastOfStream(const CBlockIndex* pindex, int nStream, const Consensus::Params& params)
+{
+    while (pindex && GetStream(pindex) != nStream) {
+        // No minotaurx blocks before the fork, don't walk back to genesis for them
+        if (nStream == NETSTATS_MINOTAURX && !IsMinoEnabled(pindex, params))
+            return nullptr;
+        pindex = pindex->pprev;
+    }
+    return pindex;
+}
+
+// Previous block of the stream of pindex. The same type predecessor also tells
+// proof-of-stake blocks apart by their PoW type bits, the streams do not.
+static const CBlockIndex* GetPrevOfStream(const CBlockIndex* pindex, int nStream, const Consensus::Params& params)
+{
+    if (nStream != NETSTATS_POS)
+        return pindex->pprevSameType;
+    return FindLastOfStream(pindex->pprev, nStream, params);
+}
+
+static arith_uint256 GetStreamBlockProof(const CBlockIndex* pindex)
+{
+    // Hashes for proof-of-work, kernels per satoshi of stake weight for proof-of-stake
+    return pindex->IsProofOfStake() ? GetBlockProof(*pindex) : GetBlockProof(*pindex, pindex->GetPoWType());
+}
+
+CNetworkStatsEstimator::CNetworkStatsEstimator(unsigned int nWindowIn) : nWindow(std::max(nWindowIn, 2u)), pindexTip(nullptr)
+{
+}
+
+void CNetworkStatsEstimator::PushFront(int nStream, const CBlockIndex* pindex)
+{
+    Sample sample{pindex, GetStreamBlockProof(pindex)};
+    workSum[nStream] += sample.work;
+    samples[nStream].push_front(sample);
+}
+
+void CNetworkStatsEstimator::PushBack(int nStream, const CBlockIndex* pindex)
+{
+    Sample sample{pindex, GetStreamBlockProof(pindex)};
+    workSum[nStream] += sample.work;
+    samples[nStream].push_back(sample);
+}
+
+void CNetworkStatsEstimator::PopFront(int nStream)
+{
+    workSum[nStream] -= samples[nStream].front().work;
+    samples[nStream].pop_front();
+}
+
+void CNetworkStatsEstimator::PopBack(int nStream)
+{
+    workSum[nStream] -= samples[nStream].back().work;
+    samples[nStream].pop_back();
+}
+
+void CNetworkStatsEstimator::Update(const CBlockIndex* pindexNew)
+{
+    if (!pindexNew)
+        return;
+    const Consensus::Params& params = Params().GetConsensus();
+
+    LOCK(cs);
+    if (pindexNew == pindexTip)
+        return;
+
+    // Drop the blocks that left the active chain. The first time, the windows
+    // are filled backwards from the new tip instead.
+    const CBlockIndex* pindexFork = pindexTip ? LastCommonAncestor(pindexTip, pindexNew) : pindexNew;
+    const int nForkHeight = pindexFork ? pindexFork->nHeight : -1;
+    for (int s = 0; s < NETSTATS_STREAMS; s++) {
+        while (!samples[s].empty() && samples[s].back().pindex->nHeight > nForkHeight)
+            PopBack(s);
+    }
+
+    // Blocks connected since, newest first, at most a window of each stream
+    std::vector<const CBlockIndex*> vConnected[NETSTATS_STREAMS];
+    int nFull = 0;
+    for (const CBlockIndex* pindex = pindexNew; pindex && pindex != pindexFork && nFull < NETSTATS_STREAMS; pindex = pindex->pprev) {
+        std::vector<const CBlockIndex*>& v = vConnected[GetStream(pindex)];
+        if (v.size() < nWindow) {
+            v.push_back(pindex);
+            if (v.size() == nWindow)
+                nFull++;
+        }
+    }
+
+    for (int s = 0; s < NETSTATS_STREAMS; s++) {
+        for (auto it = vConnected[s].rbegin(); it != vConnected[s].rend(); ++it)
+            PushBack(s, *it);
+        while (samples[s].size() > nWindow)
+            PopFront(s);
+        // Top the window up from below after a reorganization or at startup
+        const CBlockIndex* pindexPrev = samples[s].empty() ? FindLastOfStream(pindexFork, s, params) : GetPrevOfStream(samples[s].front().pindex, s, params);
+        while (samples[s].size() < nWindow && pindexPrev) {
+            PushFront(s, pindexPrev);
+            pindexPrev = GetPrevOfStream(pindexPrev, s, params);
+        }
+    }
+    pindexTip = pindexNew;
+}
+
+void CNetworkStatsEstimator::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    Update(pindexNew);
+}
+
+CNetworkStats CNetworkStatsEstimator::GetStats() const
+{
+    LOCK(cs);
+    CNetworkStats stats;
+    if (!pindexTip)
+        return stats;
+    stats.nHeight = pindexTip->nHeight;
+    stats.hashBlock = pindexTip->GetBlockHash();
+    for (int s = 0; s < NETSTATS_STREAMS; s++) {
+        CBlockStreamStats& stream = stats.streams[s];
+        stream.nBlocks = samples[s].size();
+        if (samples[s].empty())
+            continue;
+        const CBlockIndex* pindexFirst = samples[s].front().pindex;
+        const CBlockIndex* pindexLast = samples[s].back().pindex;
+        stream.nHeight = pindexLast->nHeight;
+        stream.nTime = pindexLast->GetBlockTime();
+        stream.dDifficulty = GetDifficulty(pindexLast);
+        // The oldest block only marks the start of the time span
+        int64_t nTimeSpan = pindexLast->GetBlockTime() - pindexFirst->GetBlockTime();
+        if (stream.nBlocks > 1 && nTimeSpan > 0) {
+            stream.dInterval = (double)nTimeSpan / (stream.nBlocks - 1);
+            stream.dRate = (workSum[s] - samples[s].front().work).getdouble() / nTimeSpan;
+        }
+    }
+    return stats;
+}
+
+UniValue NetworkStatsToJSON(const CNetworkStats& stats)
+{
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("height", stats.nHeight));
+    result.push_back(Pair("bestblockhash", stats.hashBlock.GetHex()));
+    for (int s = 0; s < NETSTATS_STREAMS; s++) {
+        const CBlockStreamStats& stream = stats.streams[s];
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("blocks", stream.nBlocks));
+        obj.push_back(Pair("height", stream.nHeight));
+        obj.push_back(Pair("time", stream.nTime));
+        obj.push_back(Pair("difficulty", stream.dDifficulty));
+        obj.push_back(Pair("interval", stream.dInterval));
+        obj.push_back(Pair(s == NETSTATS_POS ? "netstakeweight" : "networkhashps", stream.dRate));
+        result.push_back(Pair(NETSTATS_STREAM_NAMES[s], obj));
+    }
+    return result;
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#ifndef PULSAR_NETWORKSTATS_H
+#define PULSAR_NETWORKSTATS_H
+
+#include <arith_uint256.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+
+class CBlockIndex;
+class UniValue;
+
+/** Number of blocks of each stream the estimates are taken over */
+static const unsigned int NETWORK_STATS_WINDOW = 72;
+
+/** Interleaved block streams of the chain, estimated separately */
+enum NetworkStatsStream {
+    NETSTATS_POS,
+    NETSTATS_CURVEHASH,
+    NETSTATS_MINOTAURX,
+    NETSTATS_STREAMS
+};
+extern const std::string NETSTATS_STREAM_NAMES[NETSTATS_STREAMS];
+
+/** Estimates for one stream over its last blocks */
+struct CBlockStreamStats
+{
+    //! Number of blocks the estimates are taken over
+    int nBlocks;
+    //! Height and time of the last block of the stream, -1 and 0 without any
+    int nHeight;
+    int64_t nTime;
+    //! Difficulty of the last block of the stream
+    double dDifficulty;
+    //! Mean time between consecutive blocks of the stream, in seconds
+    double dInterval;
+    //! Hashes per second for proof-of-work, stake weight in satoshis for proof-of-stake
+    double dRate;
+
+    CBlockStreamStats() : nBlocks(0), nHeight(-1), nTime(0), dDifficulty(0), dInterval(0), dRate(0) {}
+};
+
+struct CNetworkStats
+{
+    int nHeight;
+    uint256 hashBlock;
+    CBlockStreamStats streams[NETSTATS_STREAMS];
+
+    CNetworkStats() : nHeight(-1) {}
+};
+
+/**
+ * Rolling network hashrate, stake weight, block interval and difficulty
+ * estimates for each block stream, following the active tip. Every tip
+ * update only looks at the blocks it connected or disconnected, so reading
+ * the estimates never walks the chain or takes cs_main.
+ */
+class CNetworkStatsEstimator : public CValidationInterface
+{
+private:
+    struct Sample {
+        const CBlockIndex* pindex;
+        arith_uint256 work;
+    };
+
+    mutable CCriticalSection cs;
+    const unsigned int nWindow;
+    const CBlockIndex* pindexTip;
+    //! Last blocks of each stream, oldest first
+    std::deque<Sample> samples[NETSTATS_STREAMS];
+    //! Work of all samples of each stream
+    arith_uint256 workSum[NETSTATS_STREAMS];
+
+    void PushFront(int nStream, const CBlockIndex* pindex);
+    void PushBack(int nStream, const CBlockIndex* pindex);
+    void PopFront(int nStream);
+    void PopBack(int nStream);
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+
+public:
+    explicit CNetworkStatsEstimator(unsigned int nWindowIn = NETWORK_STATS_WINDOW);
+
+    /** Move the estimates to pindexNew; does nothing if they are already there */
+    void Update(const CBlockIndex* pindexNew);
+    CNetworkStats GetStats() const;
+};
+
+UniValue NetworkStatsToJSON(const CNetworkStats& stats);
+
+extern std::unique_ptr<CNetworkStatsEstimator> g_networkstats;
+
+#endif // PULSAR_NETWORKSTATS_H
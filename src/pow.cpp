@@ -8,8 +8,13 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
+#include <hash.h>
 #include <primitives/block.h>
 #include <pulsar.h>
+#include <random.h>
+#include <script/sigcache.h>
 #include <uint256.h>
 
 #include <bignum.h>
@@ -18,9 +23,13 @@
 
 #include <validation.h>
 
+#include <atomic>
+
+#include <boost/thread.hpp>
+
 // pulsar: find last block index up to pindex
 const CBlockIndex *GetLastBlockIndex(const CBlockIndex *pindex, bool fProofOfStake, const POW_TYPE powType) {
-    while (pindex && pindex->pprev && ((pindex->IsProofOfStake() != fProofOfStake) || (pindex->GetBlockHeader().GetPoWType() != powType)))
+    while (pindex && pindex->pprev && !pindex->IsSameType(fProofOfStake, powType))
         pindex = pindex->pprev;
     return pindex;
 }
@@ -53,37 +62,23 @@ unsigned int DarkGravityWave(const CBlockIndex *pindexLast, bool fProofOfStake,
     const CBlockIndex *pindexLastMatchingProof = nullptr;
     arith_uint256 bnPastTargetAvg = 0;
 
-
-	int match = 0;
-	int nomatch = 0;
+    // Only consider PoW or PoS blocks but not both; after the first matching
+    // block, pprevSameType only visits blocks of the same type
+    while (pindex && !pindex->IsSameType(fProofOfStake, powType))
+        pindex = pindex->pprev;
+    pindexLastMatchingProof = pindex;
 
     while (nCountBlocks < params.nDgwPastBlocks) {
         // Ran out of blocks, return pow limit
         if (!pindex)
             return nProofOfWorkLimit;
 
-	
-        // Only consider PoW or PoS blocks but not both
-        if (pindex->IsProofOfStake() != fProofOfStake || pindex->GetBlockHeader().GetPoWType() != powType) 
-	{
-		nomatch++;
-		//LogPrint(BCLog::ALL, "--- NO MATCH - PowType: %s PoS: %s\n", pindex->GetBlockHeader().GetPoWType(), pindex->IsProofOfStake());
-            pindex = pindex->pprev;
-            continue;
-
-        } else if (!pindexLastMatchingProof) {
-            pindexLastMatchingProof = pindex;
-        }
-		match++;
-	//LogPrint(BCLog::ALL, "--- MATCH - PowType: %s PoS: %s\n", pindex->GetBlockHeader().GetPoWType(), pindex->IsProofOfStake());
-
         arith_uint256 bnTarget = arith_uint256().SetCompact(pindex->nBits);
         bnPastTargetAvg = (bnPastTargetAvg * nCountBlocks + bnTarget) / (nCountBlocks + 1);
 
         if (++nCountBlocks != params.nDgwPastBlocks)
-            pindex = pindex->pprev;
+            pindex = pindex->pprevSameType;
     }
-	LogPrint(BCLog::ALL, "PIndex - PowType: %s PoS: %s Match: %s NoMatch %s \n", powType, fProofOfStake, match, nomatch);
     LogPrint(BCLog::ALL, "DarkGravityWave fProofOfStake=%s, pindexDGWHeight=%d, pindexLastMatchingProof=%d, nDgwPastBlocks=%d \n", fProofOfStake, pindex->nHeight, pindexLastMatchingProof->nHeight, params.nDgwPastBlocks);
 
     arith_uint256 bnNew(bnPastTargetAvg);
@@ -163,8 +158,75 @@ unsigned int GetNextTargetRequired(const CBlockIndex *pindexLast, bool fProofOfS
     return DarkGravityWave(pindexLast, fProofOfStake, params, powType);
 }
 
+namespace {
+/**
+ * Valid proof-of-work cache, to avoid hashing the same header again every
+ * time it is checked (at header acceptance, in CheckBlock, when reading the
+ * block back from disk...). MinotaurX makes every miss cost a yespower pass.
+ */
+class CPoWCache
+{
+private:
+    //! Entries are SHA256(nonce || header hash || nBits):
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_powcache;
+
+public:
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+    CPoWCache() : nHits(0), nMisses(0)
+    {
+        GetRandBytes(nonce.begin(), 32);
+        // Usable before InitPoWCache() sizes it
+        setValid.setup(1 << 10);
+    }
+
+    void ComputeEntry(uint256& entry, const CBlockHeader& header)
+    {
+        uint256 hashHeader = SerializeHash(header);
+        CSHA256().Write(nonce.begin(), 32).Write(hashHeader.begin(), 32).Write((const unsigned char*)&header.nBits, 4).Finalize(entry.begin());
+    }
 
-bool CheckProofOfWork(const CBlockHeader *pblock, const Consensus::Params &params) {
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_powcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_powcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_powcache);
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CPoWCache powCache;
+} // namespace
+
+void InitPoWCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxpowcachesize", DEFAULT_MAX_POW_CACHE_SIZE)), MAX_MAX_POW_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = powCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for proof-of-work cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+void GetPoWCacheStats(uint64_t& nHits, uint64_t& nMisses)
+{
+    nHits = powCache.nHits;
+    nMisses = powCache.nMisses;
+}
+
+static bool CheckProofOfWorkUncached(const CBlockHeader *pblock, const Consensus::Params &params) {
 
 	if (pblock->GetBlockTime() > params.powForkTime) {
 
@@ -220,3 +282,17 @@ bool CheckProofOfWork(const CBlockHeader *pblock, const Consensus::Params &param
 	}
 
 }
+
+bool CheckProofOfWork(const CBlockHeader *pblock, const Consensus::Params &params) {
+    uint256 entry;
+    powCache.ComputeEntry(entry, *pblock);
+    if (powCache.Get(entry)) {
+        ++powCache.nHits;
+        return true;
+    }
+    ++powCache.nMisses;
+    if (!CheckProofOfWorkUncached(pblock, params))
+        return false;
+    powCache.Set(entry);
+    return true;
+}
@@ -16,6 +16,11 @@ class CBlockHeader;
 class CBlockIndex;
 class uint256;
 
+/** Default for -maxpowcachesize, in MiB (131072 entries) */
+static const unsigned int DEFAULT_MAX_POW_CACHE_SIZE = 4;
+/** Maximum -maxpowcachesize allowed */
+static const int64_t MAX_MAX_POW_CACHE_SIZE = 1024;
+
 //unsigned int GetNextWorkRequiredLWMA(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params, const POW_TYPE powType); // Crow: LWMA difficulty adjustment for all pow types
 //unsigned int GetNextWorkRequiredLWMA1(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params, const POW_TYPE powType); // Crow: LWMA difficulty adjustment for all pow types
 //unsigned int GetNextWorkRequiredLWMA2(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params, const POW_TYPE powType); // Crow: LWMA difficulty adjustment for all pow types
@@ -27,8 +32,13 @@ class uint256;
 const CBlockIndex* GetLastBlockIndex(const CBlockIndex* pindex, bool fProofOfStake, const POW_TYPE powType=POW_TYPE_CURVEHASH);
 unsigned int GetNextTargetRequired(const CBlockIndex* pindexLast, bool fProofOfStake, const Consensus::Params& params, const POW_TYPE powType);
 
-/** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
+/** Check whether a block hash satisfies the proof-of-work requirement specified by nBits, remembering valid headers */
 bool CheckProofOfWork(const CBlockHeader *pblock, const Consensus::Params&);
 
+/** Size the valid proof-of-work cache from -maxpowcachesize */
+void InitPoWCache();
+/** Number of CheckProofOfWork calls answered from the cache (hits) and by hashing (misses) */
+void GetPoWCacheStats(uint64_t& nHits, uint64_t& nMisses);
+
 #endif // BITCOIN_POW_H
 
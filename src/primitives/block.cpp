@@ -8,7 +8,7 @@
 #include <tinyformat.h>
 #include <utilstrencodings.h>
 #include <crypto/common.h>
-#include <crypto/minotaurx/minotaur.h>
+#include <minotaurx.h>
 #include <validation.h>
 #include <util.h>
 
@@ -20,7 +20,7 @@ uint256 CBlockHeader::ComputePoWHash() const
                 break;
             }
             case POW_TYPE_MINOTAURX: {
-                return Minotaur(BEGIN(nVersion), END(nNonce), true);
+                return GetMinotaurXHasher().Hash(BEGIN(nVersion), END(nNonce));
                 break;
             }
             default: // Don't crash the client on invalid blockType, just return a bad hash
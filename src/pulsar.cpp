@@ -8,40 +8,121 @@
 #include <streams.h>
 #include <secp256k1.h>
 
-// PoW based on elliptic curves.
-void Pulsar(const CBlockHeader *pblock, uint32_t nNonce, uint256 *phash)
-{
-    // Write the first 76 bytes of the block header to a SHA256 state.
-    CSHA256 hasher;
+#include <algorithm>
 
-    // secp256k1 context for PoW
-    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
-    secp256k1_pubkey pubkey;
+#include <assert.h>
+#include <string.h>
 
-    unsigned char pub[65];
-    size_t publen = 65;
-    CSHA256 pubHasher;
+const size_t CCurveHashEngine::HEADER_PREFIX_SIZE;
+const size_t CCurveHashEngine::SCAN_BATCH_SIZE;
 
+CCurveHashEngine::CCurveHashEngine()
+{
+    // secp256k1 context for PoW, only the signing tables are needed
+    ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    assert(ctx != nullptr);
+}
+
+CCurveHashEngine::~CCurveHashEngine()
+{
+    secp256k1_context_destroy(ctx);
+}
+
+void CCurveHashEngine::SerializeHeaderPrefix(const CBlockHeader& header, unsigned char prefix[HEADER_PREFIX_SIZE])
+{
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *pblock;
+    ss << header;
     assert(ss.size() == 80);
-//
-    // Calculate initial SHA256 hash of blockheader and nonce
-    hasher.Write((unsigned char*)&ss[0], 76);
-    hasher.Write((unsigned char*)&nNonce, 4);
-    hasher.Finalize((unsigned char*)phash);
+    memcpy(prefix, &ss[0], HEADER_PREFIX_SIZE);
+}
+
+void CCurveHashEngine::CurveRounds(uint256* phashes, size_t nCount)
+{
+    assert(nCount <= SCAN_BATCH_SIZE);
+    secp256k1_pubkey pubkey;
+    size_t publen = 65;
 
     // 8 rounds of secp256k1 and sha256
-    for(int round=0; round<8; round++)
+    for (int round = 0; round < 8; round++)
     {
         // Assume SHA256 result as private key and compute uncompressed public key
-        assert(secp256k1_ec_pubkey_create(ctx, &pubkey, (unsigned char*)phash) == 1);
-        assert(secp256k1_ec_pubkey_serialize(ctx, pub, &publen, &pubkey, SECP256K1_EC_UNCOMPRESSED) == 1);
+        for (size_t i = 0; i < nCount; i++) {
+            assert(secp256k1_ec_pubkey_create(ctx, &pubkey, phashes[i].begin()) == 1);
+            assert(secp256k1_ec_pubkey_serialize(ctx, vchPub[i], &publen, &pubkey, SECP256K1_EC_UNCOMPRESSED) == 1);
+        }
 
         // Use SHA256 to hash resulting public key
-        CSHA256(pubHasher).Write(pub, 65).Finalize((unsigned char*)phash);
+        for (size_t i = 0; i < nCount; i++)
+            CSHA256().Write(vchPub[i], 65).Finalize(phashes[i].begin());
     }
-    secp256k1_context_destroy(ctx);
+}
+
+void CCurveHashEngine::HashFromMidstate(const CSHA256& hasherMid, const unsigned char* pchTail, const uint32_t* pnNonces, size_t nCount, uint256* phashes)
+{
+    while (nCount > 0) {
+        size_t nBatch = std::min(nCount, SCAN_BATCH_SIZE);
+
+        // Calculate initial SHA256 hash of blockheader and nonce, continuing from the midstate
+        for (size_t i = 0; i < nBatch; i++)
+            CSHA256(hasherMid).Write(pchTail, HEADER_PREFIX_SIZE - 64).Write((const unsigned char*)&pnNonces[i], 4).Finalize(phashes[i].begin());
+
+        CurveRounds(phashes, nBatch);
+
+        pnNonces += nBatch;
+        phashes += nBatch;
+        nCount -= nBatch;
+    }
+}
+
+void CCurveHashEngine::Hash(const unsigned char prefix[HEADER_PREFIX_SIZE], uint32_t nNonce, uint256* phash)
+{
+    // Calculate initial SHA256 hash of blockheader and nonce
+    CSHA256().Write(prefix, HEADER_PREFIX_SIZE).Write((unsigned char*)&nNonce, 4).Finalize(phash->begin());
+    CurveRounds(phash, 1);
+}
+
+void CCurveHashEngine::HashNonces(const unsigned char prefix[HEADER_PREFIX_SIZE], const uint32_t* pnNonces, size_t nCount, uint256* phashes)
+{
+    CSHA256 hasherMid;
+    hasherMid.Write(prefix, 64);
+    HashFromMidstate(hasherMid, prefix + 64, pnNonces, nCount, phashes);
+}
+
+void CCurveHashEngine::SetScanHeader(const CBlockHeader& header)
+{
+    unsigned char prefix[HEADER_PREFIX_SIZE];
+    SerializeHeaderPrefix(header, prefix);
+    midstate.Reset().Write(prefix, 64);
+    memcpy(tail, prefix + 64, sizeof(tail));
+}
+
+void CCurveHashEngine::ScanNonces(uint32_t nFirstNonce, size_t nCount, uint256* phashes)
+{
+    uint32_t vNonces[SCAN_BATCH_SIZE];
+    while (nCount > 0) {
+        size_t nBatch = std::min(nCount, SCAN_BATCH_SIZE);
+        for (size_t i = 0; i < nBatch; i++)
+            vNonces[i] = nFirstNonce + i;
+        HashFromMidstate(midstate, tail, vNonces, nBatch, phashes);
+
+        nFirstNonce += nBatch;
+        phashes += nBatch;
+        nCount -= nBatch;
+    }
+}
+
+CCurveHashEngine& GetCurveHashEngine()
+{
+    static thread_local CCurveHashEngine engine;
+    return engine;
+}
+
+// PoW based on elliptic curves.
+void Pulsar(const CBlockHeader *pblock, uint32_t nNonce, uint256 *phash)
+{
+    unsigned char prefix[CCurveHashEngine::HEADER_PREFIX_SIZE];
+    CCurveHashEngine::SerializeHeaderPrefix(*pblock, prefix);
+    GetCurveHashEngine().Hash(prefix, nNonce, phash);
 }
 
 
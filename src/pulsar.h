@@ -1,9 +1,77 @@
+#ifndef PULSAR_PULSAR_H
+#define PULSAR_PULSAR_H
+
 #include <primitives/block.h>
 #include <crypto/sha256.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
+struct secp256k1_context_struct;
+
+/**
+ * CurveHash engine.
+ * Owns a secp256k1 signing context and the scratch buffers needed to hash
+ * headers, so the context and its precomputed generator tables are built once
+ * per engine instead of once per hash. An engine is not thread safe; every
+ * thread uses its own through GetCurveHashEngine().
+ */
+class CCurveHashEngine
+{
+public:
+    //! Size of the serialized header part that does not depend on the nonce
+    static const size_t HEADER_PREFIX_SIZE = 76;
+    //! Number of nonces hashed side by side when scanning
+    static const size_t SCAN_BATCH_SIZE = 8;
+
+    CCurveHashEngine();
+    ~CCurveHashEngine();
+
+    CCurveHashEngine(const CCurveHashEngine&) = delete;
+    CCurveHashEngine& operator=(const CCurveHashEngine&) = delete;
+
+    /** Serialize the first 76 bytes (everything but the nonce) of a block header */
+    static void SerializeHeaderPrefix(const CBlockHeader& header, unsigned char prefix[HEADER_PREFIX_SIZE]);
+
+    /** Compute the CurveHash of a serialized header prefix followed by nNonce */
+    void Hash(const unsigned char prefix[HEADER_PREFIX_SIZE], uint32_t nNonce, uint256* phash);
+
+    /** Compute the CurveHashes of nCount nonces against the same serialized header prefix */
+    void HashNonces(const unsigned char prefix[HEADER_PREFIX_SIZE], const uint32_t* pnNonces, size_t nCount, uint256* phashes);
+
+    /**
+     * Start scanning nonces of a block header: serialize it once and cache
+     * the SHA-256 midstate of its first 64 bytes. Must be called again
+     * whenever anything but the nonce changes.
+     */
+    void SetScanHeader(const CBlockHeader& header);
+
+    /** Compute the CurveHashes of nCount consecutive nonces of the scan header, starting at nFirstNonce */
+    void ScanNonces(uint32_t nFirstNonce, size_t nCount, uint256* phashes);
+
+private:
+    secp256k1_context_struct* ctx;
+    //! Serialized public keys, one per batch lane
+    unsigned char vchPub[SCAN_BATCH_SIZE][65];
+
+    //! SHA-256 state after the first 64 bytes of the scan header
+    CSHA256 midstate;
+    //! Bytes 64..75 of the scan header
+    unsigned char tail[HEADER_PREFIX_SIZE - 64];
+
+    /** Hash nonces from a header midstate, SCAN_BATCH_SIZE at a time */
+    void HashFromMidstate(const CSHA256& hasherMid, const unsigned char* pchTail, const uint32_t* pnNonces, size_t nCount, uint256* phashes);
+
+    /** Run the 8 rounds of secp256k1 and sha256 over up to SCAN_BATCH_SIZE initial header hashes, all lanes one round at a time */
+    void CurveRounds(uint256* phashes, size_t nCount);
+};
+
+/** Return the calling thread's CurveHash engine, creating it on first use */
+CCurveHashEngine& GetCurveHashEngine();
+
 // Pulsar PoW
 void Pulsar(const CBlockHeader *pblock, uint32_t nNonce, uint256 *phash);
 
 void GetPoWHash(const CBlockHeader *pblock, uint256 *thash);
 
-void GetPowHash();
\ No newline at end of file
+#endif // PULSAR_PULSAR_H
@@ -32,6 +32,9 @@
 
 #include <miner.h>
 #include <kernel.h>
+#include <stakemodifiers.h>
+#include <supplyindex.h>
+#include <net_processing.h>
 
 #include <boost/thread/thread.hpp> // boost::thread::interrupt
 
@@ -59,7 +62,7 @@ extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue&
 
 CBlockIndex* GetLastBlockIndex4Algo(CBlockIndex* pindex, POW_TYPE powType)
 {
-    while (pindex && pindex->pprev && pindex->GetBlockHeader().GetPoWType() != powType)
+    while (pindex && pindex->pprev && pindex->GetPoWType() != powType)
         pindex = pindex->pprev;
     return pindex;
 }
@@ -715,6 +718,169 @@ UniValue getblockhash(const JSONRPCRequest& request)
     return pblockindex->GetBlockHash().GetHex();
 }
 
+UniValue getstakemodifiers(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "getstakemodifiers height ( count )\n"
+            "\nReturns the stake modifiers of the best-block-chain from the stake modifier table.\n"
+            "Requires -stakemodifiertable.\n"
+            "\nArguments:\n"
+            "1. height         (numeric, required) The height of the first block\n"
+            "2. count          (numeric, optional, default=1) The number of blocks, at most 2000\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"height\" : n,         (numeric) The block height\n"
+            "    \"hash\" : \"hash\",      (string) The block hash\n"
+            "    \"kernel\" : \"hash\",    (string) The block hash for proof-of-work, the kernel prevout hash for proof-of-stake\n"
+            "    \"modifier\" : \"hex\",   (string) The stake modifier\n"
+            "    \"proofhash\" : \"hash\"  (string) The proof-of-stake hash, zero for proof-of-work\n"
+            "  }, ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getstakemodifiers", "1000 100")
+            + HelpExampleRpc("getstakemodifiers", "1000, 100")
+        );
+
+    LOCK(cs_main);
+
+    int nHeight = request.params[0].get_int();
+    int nCount = request.params[1].isNull() ? 1 : request.params[1].get_int();
+    if (nHeight < 0 || nHeight > chainActive.Height())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+    if (nCount < 1 || nCount > 2000)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Count out of range");
+    if (!pstakemodifiers)
+        throw JSONRPCError(RPC_MISC_ERROR, "Stake modifier table is disabled, use -stakemodifiertable");
+
+    UniValue result(UniValue::VARR);
+    for (int h = nHeight; h < nHeight + nCount && h <= chainActive.Height(); h++) {
+        CStakeModifierRecord record;
+        if (!pstakemodifiers->Lookup(h, record))
+            break;
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("height", h));
+        entry.push_back(Pair("hash", record.hashBlock.GetHex()));
+        entry.push_back(Pair("kernel", record.hashKernel.GetHex()));
+        entry.push_back(Pair("modifier", record.bnStakeModifier.GetHex()));
+        entry.push_back(Pair("proofhash", record.hashProofOfStake.GetHex()));
+        result.push_back(entry);
+    }
+    return result;
+}
+
+UniValue getsupplystats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getsupplystats height_start ( height_end verbose )\n"
+            "\nReturns money supply and minting statistics over a range of the best-block-chain.\n"
+            "Requires -supplyindex.\n"
+            "\nArguments:\n"
+            "1. height_start   (numeric, required) The height of the first block of the range\n"
+            "2. height_end     (numeric, optional, default=height_start) The height of the last block of the range\n"
+            "3. verbose        (boolean, optional, default=false) Also list the statistics of every block, for at most 2000 blocks\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"height_start\" : n,          (numeric) The height of the first block\n"
+            "  \"height_end\" : n,            (numeric) The height of the last block\n"
+            "  \"moneysupply_start\" : x.xxx, (numeric) The money supply before the first block\n"
+            "  \"moneysupply_end\" : x.xxx,   (numeric) The money supply after the last block\n"
+            "  \"feesburned\" : x.xxx,        (numeric) The transaction fees destroyed in the range\n"
+            "  \"staked\" : x.xxx,            (numeric) The value of the coinstake inputs in the range\n"
+            "  \"pos\" : {                    (json object) Proof-of-stake blocks, likewise \"curvehash\", \"minotaurx\" and \"total\"\n"
+            "    \"blocks\" : n,              (numeric) The number of blocks\n"
+            "    \"minted\" : x.xxx           (numeric) The coins minted by these blocks\n"
+            "  },\n"
+            "  ...\n"
+            "  \"blocks\" : [                 (array, verbose only)\n"
+            "    {\n"
+            "      \"height\" : n,            (numeric) The block height\n"
+            "      \"hash\" : \"hash\",         (string) The block hash\n"
+            "      \"type\" : \"pos\"|\"curvehash\"|\"minotaurx\", (string) The kind of block\n"
+            "      \"moneysupply\" : x.xxx,   (numeric) The money supply after the block\n"
+            "      \"minted\" : x.xxx,        (numeric) The coins minted by the block\n"
+            "      \"feesburned\" : x.xxx,    (numeric) The transaction fees destroyed by the block\n"
+            "      \"staked\" : x.xxx         (numeric) The value of the coinstake inputs\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getsupplystats", "1000 2000")
+            + HelpExampleRpc("getsupplystats", "1000, 2000")
+        );
+
+    if (!g_supplyindex)
+        throw JSONRPCError(RPC_MISC_ERROR, "Supply index not enabled, use -supplyindex");
+    if (!g_supplyindex->IsSynced())
+        throw JSONRPCError(RPC_IN_WARMUP, "Supply index is still being built");
+
+    // Let the index catch up with blocks connected before this call
+    SyncWithValidationInterfaceQueue();
+
+    LOCK(cs_main);
+
+    int nHeightStart = request.params[0].get_int();
+    int nHeightEnd = request.params[1].isNull() ? nHeightStart : request.params[1].get_int();
+    bool fVerbose = request.params[2].isNull() ? false : request.params[2].get_bool();
+    if (nHeightStart < 0 || nHeightStart > chainActive.Height())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Start height out of range");
+    if (nHeightEnd < nHeightStart || nHeightEnd > chainActive.Height())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "End height out of range");
+    if (fVerbose && nHeightEnd - nHeightStart >= 2000)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Range too large for verbose output");
+
+    // Range totals are the difference of the running totals at both ends
+    CSupplyStats statsBefore, statsEnd;
+    if ((nHeightStart > 0 && !g_supplyindex->Lookup(nHeightStart - 1, statsBefore)) || !g_supplyindex->Lookup(nHeightEnd, statsEnd))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Supply index entry not found");
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("height_start", nHeightStart));
+    result.push_back(Pair("height_end", nHeightEnd));
+    result.push_back(Pair("moneysupply_start", ValueFromAmount(statsBefore.nMoneySupply)));
+    result.push_back(Pair("moneysupply_end", ValueFromAmount(statsEnd.nMoneySupply)));
+    result.push_back(Pair("feesburned", ValueFromAmount(statsEnd.nFeesBurnedTotal - statsBefore.nFeesBurnedTotal)));
+    result.push_back(Pair("staked", ValueFromAmount(statsEnd.nStakedTotal - statsBefore.nStakedTotal)));
+    int64_t nBlocksTotal = 0;
+    CAmount nMintTotal = 0;
+    for (int i = 0; i < SUPPLY_TYPES; i++) {
+        int64_t nBlocks = statsEnd.nBlocksTotal[i] - statsBefore.nBlocksTotal[i];
+        CAmount nMint = statsEnd.nMintTotal[i] - statsBefore.nMintTotal[i];
+        UniValue type(UniValue::VOBJ);
+        type.push_back(Pair("blocks", nBlocks));
+        type.push_back(Pair("minted", ValueFromAmount(nMint)));
+        result.push_back(Pair(SUPPLY_TYPE_NAMES[i], type));
+        nBlocksTotal += nBlocks;
+        nMintTotal += nMint;
+    }
+    UniValue total(UniValue::VOBJ);
+    total.push_back(Pair("blocks", nBlocksTotal));
+    total.push_back(Pair("minted", ValueFromAmount(nMintTotal)));
+    result.push_back(Pair("total", total));
+
+    if (fVerbose) {
+        UniValue blocks(UniValue::VARR);
+        for (int h = nHeightStart; h <= nHeightEnd; h++) {
+            CSupplyStats stats;
+            if (!g_supplyindex->Lookup(h, stats))
+                throw JSONRPCError(RPC_DATABASE_ERROR, "Supply index entry not found");
+            UniValue entry(UniValue::VOBJ);
+            entry.push_back(Pair("height", h));
+            entry.push_back(Pair("hash", stats.hashBlock.GetHex()));
+            entry.push_back(Pair("type", stats.nType < SUPPLY_TYPES ? SUPPLY_TYPE_NAMES[stats.nType] : "unknown"));
+            entry.push_back(Pair("moneysupply", ValueFromAmount(stats.nMoneySupply)));
+            entry.push_back(Pair("minted", ValueFromAmount(stats.nMint)));
+            entry.push_back(Pair("feesburned", ValueFromAmount(stats.nFeesBurned)));
+            entry.push_back(Pair("staked", ValueFromAmount(stats.nStaked)));
+            blocks.push_back(entry);
+        }
+        result.push_back(Pair("blocks", blocks));
+    }
+    return result;
+}
+
 UniValue getblockheader(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -1220,6 +1386,7 @@ UniValue getchaintips(const JSONRPCRequest& request)
             "    \"hash\": \"xxxx\",\n"
             "    \"branchlen\": 1          (numeric) length of branch connecting the tip to the main chain\n"
             "    \"status\": \"xxxx\"        (string) status of the chain (active, valid-fork, valid-headers, headers-only, invalid)\n"
+            "    \"waiting\": true|false     (boolean) whether the tip block was received and is waiting for its parent to be accepted\n"
             "  }\n"
             "]\n"
             "Possible values for status:\n"
@@ -1296,6 +1463,7 @@ UniValue getchaintips(const JSONRPCRequest& request)
             status = "unknown";
         }
         obj.push_back(Pair("status", status));
+        obj.push_back(Pair("waiting", IsBlockWaiting(block)));
 
         res.push_back(obj);
     }
@@ -1559,6 +1727,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           {} },
+    { "blockchain",         "getstakemodifiers",      &getstakemodifiers,      {"height","count"} },
+    { "blockchain",         "getsupplystats",         &getsupplystats,         {"height_start","height_end","verbose"} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"} },
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
@@ -48,6 +48,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getbalance", 1, "minconf" },
     { "getbalance", 2, "include_watchonly" },
     { "getblockhash", 0, "height" },
+    { "getstakemodifiers", 0, "height" },
+    { "getstakemodifiers", 1, "count" },
+    { "getsupplystats", 0, "height_start" },
+    { "getsupplystats", 1, "height_end" },
+    { "getsupplystats", 2, "verbose" },
     { "waitforblockheight", 0, "height" },
     { "waitforblockheight", 1, "timeout" },
     { "waitforblock", 1, "timeout" },
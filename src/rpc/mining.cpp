@@ -15,6 +15,7 @@
 #include <validation.h>
 #include <miner.h>
 #include <net.h>
+#include <networkstats.h>
 #include <pow.h>
 #include <rpc/blockchain.h>
 #include <rpc/mining.h>
@@ -25,6 +26,7 @@
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <wallet/rpcwallet.h>
 #include <wallet/wallet.h>
 #include <kernel.h>
 
@@ -65,7 +67,7 @@ UniValue GetNetworkHashPS(int lookup, int height, POW_TYPE powType) {
 
      // Skip incorrect powType and PoS
 
-    while(IsMinoEnabled(pb, Params().GetConsensus()) && (pb->GetBlockHeader().GetPoWType() != powType || pb->IsProofOfStake()) ) {
+    while(IsMinoEnabled(pb, Params().GetConsensus()) && !pb->IsSameType(false, powType) ) {
 
         assert (pb->pprev);
         pb = pb->pprev;
@@ -85,7 +87,7 @@ UniValue GetNetworkHashPS(int lookup, int height, POW_TYPE powType) {
         pb = pb->pprev;
 
 
-        while(IsMinoEnabled(pb, Params().GetConsensus()) && (pb->GetBlockHeader().GetPoWType() != powType || pb->IsProofOfStake()) ) {
+        while(IsMinoEnabled(pb, Params().GetConsensus()) && !pb->IsSameType(false, powType) ) {
 
             assert (pb->pprev);
             pb = pb->pprev;
@@ -189,6 +191,8 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
         nHeightEnd = nHeight+nGenerate;
     }
     unsigned int nExtraNonce = 0;
+    uint64_t nHashesDone = 0;
+    int64_t nTimeStart = GetTimeMicros();
     UniValue blockHashes(UniValue::VARR);
     while (nHeight < nHeightEnd)
     {
@@ -201,11 +205,35 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
             LOCK(cs_main);
             IncrementExtraNonce(pblock, chainActive.Tip(), nExtraNonce);
         }
-        while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock, Params().GetConsensus())) {
-//        while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock->GetPoWHash(), pblock->nBits, Params().GetConsensus())) {
-            ++pblock->nNonce;
-            --nMaxTries;
+        const uint32_t nFirstNonce = pblock->nNonce;
+        if (powType == POW_TYPE_CURVEHASH && pblock->GetBlockTime() > Params().GetConsensus().powForkTime) {
+            // Hash nonces from the header midstate a batch at a time, and only
+            // run the full check on hashes that reach the target
+            CCurveHashEngine& engine = GetCurveHashEngine();
+            engine.SetScanHeader(*pblock);
+            arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
+            uint256 hashes[CCurveHashEngine::SCAN_BATCH_SIZE];
+            bool fFound = false;
+            while (!fFound && nMaxTries > 0 && pblock->nNonce < nInnerLoopCount) {
+                engine.ScanNonces(pblock->nNonce, CCurveHashEngine::SCAN_BATCH_SIZE, hashes);
+                for (const uint256& hash : hashes) {
+                    if (UintToArith256(hash) <= hashTarget && CheckProofOfWork(pblock, Params().GetConsensus())) {
+                        fFound = true;
+                        break;
+                    }
+                    ++pblock->nNonce;
+                    --nMaxTries;
+                    if (nMaxTries == 0 || pblock->nNonce == nInnerLoopCount)
+                        break;
+                }
+            }
+        } else {
+            while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock, Params().GetConsensus())) {
+                ++pblock->nNonce;
+                --nMaxTries;
+            }
         }
+        nHashesDone += pblock->nNonce - nFirstNonce + 1;
         if (nMaxTries == 0) {
             break;
         }
@@ -225,6 +253,7 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
             coinbaseScript->KeepScript();
         }
     }
+    UpdateHashRate("generate", nHashesDone, GetTimeMicros() - nTimeStart);
     return blockHashes;
 }
 
@@ -298,7 +327,19 @@ UniValue getmininginfo(const JSONRPCRequest& request)
                 "  \"difficulty_algorithm\": x.x (numeric) the current difficulty for mino once activated per algorithm\n"
                 "  \"networkhashps\": nnn,      (numeric) The network hashes per second\n"
                 "  \"pooledtx\": n              (numeric) The size of the mempool\n"
+                "  \"hashespersec\": nnn,       (numeric) The combined hashes per second of the local mining threads\n"
+                "  \"threadhashespersec\": {   (json object) The last measured hashes per second of each local mining thread\n"
+                "      \"name\": nnn,          (numeric) Hashes per second of the thread\n"
+                "      ...\n"
+                "  },\n"
                 "  \"chain\": \"xxxx\",           (string) current network name as defined in BIP70 (main, test, regtest)\n"
+                "  \"stakeminter\": {           (json object) Outcomes of the local stake minter\n"
+                "      \"searches\": nnn,       (numeric) Kernel searches\n"
+                "      \"found\": nnn,          (numeric) Proof-of-stake blocks minted\n"
+                "      \"late\": nnn,           (numeric) Minted blocks that were stale or rejected when submitted\n"
+                "      \"orphaned\": nnn,       (numeric) Minted blocks disconnected from the active chain afterwards\n"
+                "      \"lostrate\": x.xxx      (numeric) Share of minted blocks that were late or orphaned\n"
+                "  },\n"
                 "  \"warnings\": \"...\"          (string) any network and blockchain warnings\n"
                 "  \"errors\": \"...\"            (string) DEPRECATED. Same as warnings. Only shown when pulsard is started with -deprecatedrpc=getmininginfo\n"
                 "}\n"
@@ -350,11 +391,28 @@ UniValue getmininginfo(const JSONRPCRequest& request)
         obj.push_back(Pair("networkhashps",    getnetworkhashps(request)));
         obj.push_back(Pair("networkghps",      getnetworkghps(request)));
         obj.push_back(Pair("pooledtx",         (uint64_t)mempool.size()));
+        double dHashesPerSec = 0;
+        UniValue threadHashRates(UniValue::VOBJ);
+        for (const auto& entry : GetHashRates()) {
+            threadHashRates.push_back(Pair(entry.first, entry.second));
+            if (entry.first != "generate")
+                dHashesPerSec += entry.second;
+        }
+        obj.push_back(Pair("hashespersec",     dHashesPerSec));
+        obj.push_back(Pair("threadhashespersec", threadHashRates));
         obj.push_back(Pair("chain",            Params().NetworkIDString()));
         weight.push_back(Pair("minimum",    (uint64_t)nWeight));
         weight.push_back(Pair("maximum",    (uint64_t)0));
         weight.push_back(Pair("combined",  (uint64_t)nWeight));
         obj.push_back(Pair("stakeweight", weight));
+        StakeMinterStats minterStats = GetStakeMinterStats();
+        UniValue minter(UniValue::VOBJ);
+        minter.push_back(Pair("searches",   minterStats.nSearches));
+        minter.push_back(Pair("found",      minterStats.nFound));
+        minter.push_back(Pair("late",       minterStats.nLate));
+        minter.push_back(Pair("orphaned",   minterStats.nOrphaned));
+        minter.push_back(Pair("lostrate",   minterStats.nFound ? (double)(minterStats.nLate + minterStats.nOrphaned) / minterStats.nFound : 0.0));
+        obj.push_back(Pair("stakeminter", minter));
 
         if (IsDeprecatedRPCEnabled("getmininginfo")) {
             obj.push_back(Pair("errors",       GetWarnings("statusbar")));
@@ -566,7 +624,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     if (IsInitialBlockDownload())
         throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Pulsar is downloading blocks...");
 
-    static unsigned int nTransactionsUpdatedLast;
+    static BlockTemplateCache templateCache;
 
     if (!lpval.isNull())
     {
@@ -587,7 +645,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         {
             // NOTE: Spec does not specify behaviour for non-string longpollid, but this makes testing easier
             hashWatchedChain = chainActive.Tip()->GetBlockHash();
-            nTransactionsUpdatedLastLP = nTransactionsUpdatedLast;
+            nTransactionsUpdatedLastLP = templateCache.GetTransactionsUpdated();
         }
 
         // Release the wallet and main lock while waiting
@@ -616,38 +674,11 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
 
     bool fSupportsSegwit = setClientRules.find("segwit") != setClientRules.end();
 
-    // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t nStart;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    // Cache whether the last invocation was with segwit support, to avoid returning
-    // a segwit-block to a non-segwit caller.
-    static bool fLastTemplateSupportsSegwit = true;
-    static POW_TYPE lastPowType = NUM_BLOCK_TYPES;
-    if (pindexPrev != chainActive.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5) ||
-        fLastTemplateSupportsSegwit != fSupportsSegwit ||
-	lastPowType != powType)
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = nullptr;
-
-        // Store the pindexBest used before CreateNewBlock, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = chainActive.Tip();
-        nStart = GetTime();
-        fLastTemplateSupportsSegwit = fSupportsSegwit;
-
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-	pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy, true, nullptr, nullptr, powType);
-        //pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy, fSupportsSegwit, powType);
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
-    }
+    // Update block, shared with other algorithms and long poll waiters on the same tip
+    CBlockTemplate* pblocktemplate = templateCache.Get(Params(), powType);
+    if (!pblocktemplate)
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    const CBlockIndex* pindexPrev = templateCache.GetPrevBlock();
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
 
     // Update nTime
@@ -721,7 +752,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     result.push_back(Pair("transactions", transactions));
     result.push_back(Pair("coinbaseaux", aux));
     result.push_back(Pair("coinbasevalue", (int64_t)pblock->vtx[0]->vout[0].nValue));
-    result.push_back(Pair("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast)));
+    result.push_back(Pair("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(templateCache.GetTransactionsUpdated())));
     result.push_back(Pair("target", hashTarget.GetHex()));
     result.push_back(Pair("mintime", (int64_t)pindexPrev->GetMedianTimePast()+1));
     result.push_back(Pair("mutable", aMutable));
@@ -918,11 +949,106 @@ UniValue estimatesmartfee(const JSONRPCRequest& request)
     return result;
 }
 
+// pulsar: kernel hashes a proof-of-stake block with these bits needs, per satoshi of stake weight
+static double GetStakeKernelsPerBlock(unsigned int nBits)
+{
+    arith_uint256 bnTarget;
+    bool fNegative;
+    bool fOverflow;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || bnTarget == 0)
+        return 0;
+    return ((~bnTarget / (bnTarget + 1)) + 1).getdouble();
+}
+
+UniValue getnetworkstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getnetworkstats\n"
+            "\nReturns rolling estimates of the network hashrate of each proof-of-work algorithm and of\n"
+            "the network stake weight, over the last " + std::to_string(NETWORK_STATS_WINDOW) + " blocks of each kind.\n"
+            "They are updated with every new tip, so polling this is cheap.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"height\": nnn,              (numeric) The height of the tip the estimates are for\n"
+            "  \"bestblockhash\": \"hash\",    (string) The hash of that tip\n"
+            "  \"pos\": {                    (json object) Proof-of-stake blocks\n"
+            "      \"blocks\": nnn,          (numeric) The number of blocks the estimates are taken over\n"
+            "      \"height\": nnn,          (numeric) The height of the last block, -1 if there is none\n"
+            "      \"time\": ttt,            (numeric) The time of the last block\n"
+            "      \"difficulty\": x.xxx,    (numeric) The difficulty of the last block\n"
+            "      \"interval\": x.xxx,      (numeric) The mean time between blocks, in seconds\n"
+            "      \"netstakeweight\": nnn   (numeric) The estimated stake weight of the network, in satoshis\n"
+            "  },\n"
+            "  \"curvehash\": {              (json object) Curvehash blocks, with the same fields as \"pos\" except:\n"
+            "      \"networkhashps\": nnn    (numeric) The estimated network hashes per second\n"
+            "  },\n"
+            "  \"minotaurx\": { ... }        (json object) Minotaurx blocks, as \"curvehash\"\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getnetworkstats", "")
+            + HelpExampleRpc("getnetworkstats", "")
+        );
+
+    if (!g_networkstats)
+        throw JSONRPCError(RPC_IN_WARMUP, "Network estimates are not available yet");
+    return NetworkStatsToJSON(g_networkstats->GetStats());
+}
+
+UniValue getstakinginfo(const JSONRPCRequest& request)
+{
+    CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
+        return NullUniValue;
+    }
+
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getstakinginfo\n"
+            "\nReturns a json object containing staking-related information."
+            "\nResult:\n"
+            "{\n"
+            "  \"enabled\": true|false,      (boolean) Whether staking is enabled\n"
+            "  \"staking\": true|false,      (boolean) Whether the wallet has mature coins to stake with\n"
+            "  \"weight\": nnn,              (numeric) The stake weight of the wallet, in satoshis\n"
+            "  \"netstakeweight\": nnn,      (numeric) The estimated stake weight of the network, in satoshis\n"
+            "  \"difficulty\": xxx.xxxxx     (numeric) The proof-of-stake difficulty of the next block\n"
+            "  \"expectedtime\": nnn,        (numeric) The expected time to stake a block with this weight, in seconds, -1 without weight\n"
+            "  \"warnings\": \"...\"          (string) any staking warnings\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getstakinginfo", "")
+            + HelpExampleRpc("getstakinginfo", "")
+        );
+
+    LOCK2(cs_main, pwallet->cs_wallet);
+
+    uint64_t nWeight = pwallet->GetStakeWeight();
+    unsigned int nBits = GetNextTargetRequired(chainActive.Tip(), true, Params().GetConsensus(), POW_TYPE_CURVEHASH);
+    double dKernelsPerBlock = GetStakeKernelsPerBlock(nBits);
+
+    CBlockIndex indexNext;
+    indexNext.nBits = nBits;
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("enabled",          gArgs.GetBoolArg("-staking", true)));
+    obj.push_back(Pair("staking",          nWeight > 0 && !pwallet->IsLocked()));
+    obj.push_back(Pair("weight",           nWeight));
+    obj.push_back(Pair("netstakeweight",   g_networkstats ? g_networkstats->GetStats().streams[NETSTATS_POS].dRate : 0));
+    obj.push_back(Pair("difficulty",       GetDifficulty(&indexNext)));
+    obj.push_back(Pair("expectedtime",     nWeight > 0 ? (int64_t)(dKernelsPerBlock / nWeight) : -1));
+    obj.push_back(Pair("warnings",         strMintWarning));
+    return obj;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "mining",             "getnetworkhashps",       &getnetworkhashps,       {"nblocks","height"} },
     { "mining",             "getmininginfo",          &getmininginfo,          {} },
+    { "mining",             "getstakinginfo",         &getstakinginfo,         {} },
+    { "mining",             "getnetworkstats",        &getnetworkstats,        {} },
     { "mining",             "getblocktemplate",       &getblocktemplate,       {"template_request"} },
     { "mining",             "submitblock",            &submitblock,            {"hexdata","dummy"} },
 
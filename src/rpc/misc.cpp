@@ -11,8 +11,10 @@
 #include <init.h>
 #include <validation.h>
 #include <httpserver.h>
+#include <minotaurx.h>
 #include <net.h>
 #include <netbase.h>
+#include <pow.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -458,6 +460,26 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCPoWCacheInfo()
+{
+    uint64_t nHits, nMisses;
+    GetPoWCacheStats(nHits, nMisses);
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("hits", nHits));
+    obj.push_back(Pair("misses", nMisses));
+    return obj;
+}
+
+static UniValue RPCMinotaurXMemoryInfo()
+{
+    MinotaurXMemoryStats stats = GetMinotaurXMemoryStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("hashers", uint64_t(stats.nHashers)));
+    obj.push_back(Pair("hugepages", uint64_t(stats.nHugePageHashers)));
+    obj.push_back(Pair("used", uint64_t(stats.nBytes)));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -499,6 +521,15 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"powcache\": {             (json object) Information about the proof-of-work cache\n"
+            "    \"hits\": xxxxx,          (numeric) Number of proof-of-work checks answered from the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Number of proof-of-work checks that had to hash the header\n"
+            "  },\n"
+            "  \"minotaurx\": {            (json object) Information about the MinotaurX hashers of the validation and mining threads\n"
+            "    \"hashers\": xxxxx,       (numeric) Number of hashers\n"
+            "    \"hugepages\": xxxxx,     (numeric) Number of hashers whose yespower arena is backed by huge pages\n"
+            "    \"used\": xxxxx,          (numeric) Number of bytes held by the hashers\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -512,6 +543,8 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+        obj.push_back(Pair("powcache", RPCPoWCacheInfo()));
+        obj.push_back(Pair("minotaurx", RPCMinotaurXMemoryInfo()));
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -106,6 +106,9 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "       n,                        (numeric) The heights of blocks we're currently asking from this peer\n"
             "       ...\n"
             "    ],\n"
+            "    \"waitingblocks\": n,        (numeric) The number of blocks from this peer waiting for their parent to be accepted\n"
+            "    \"waitingbytes\": n,         (numeric) The total size of the blocks from this peer waiting for their parent\n"
+            "    \"waitingevicted\": n,       (numeric) The number of blocks from this peer dropped while waiting for their parent\n"
             "    \"whitelisted\": true|false, (boolean) Whether the peer is whitelisted\n"
             "    \"bytessent_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes sent aggregated by message type\n"
@@ -172,6 +175,9 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
                 heights.push_back(height);
             }
             obj.push_back(Pair("inflight", heights));
+            obj.push_back(Pair("waitingblocks", statestats.nBlocksWait));
+            obj.push_back(Pair("waitingbytes", (uint64_t)statestats.nBlocksWaitBytes));
+            obj.push_back(Pair("waitingevicted", statestats.nBlocksWaitEvicted));
         }
         obj.push_back(Pair("whitelisted", stats.fWhitelisted));
 
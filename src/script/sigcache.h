@@ -53,4 +53,9 @@ public:
 
 void InitSignatureCache();
 
+/** Verify an ECDSA signature over an arbitrary hash, consulting the signature cache
+ *  first. Used for signatures that are not part of a script, such as the block
+ *  signature of a proof-of-stake block. */
+bool CachingVerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& hash, bool store);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
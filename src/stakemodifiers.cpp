@@ -0,0 +1,236 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <stakemodifiers.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <streams.h>
+#include <util.h>
+#include <validation.h>
+
+std::unique_ptr<CStakeModifierTable> pstakemodifiers;
+
+static CStakeModifierRecord MakeStakeModifierRecord(const CBlockIndex* pindex)
+{
+    CStakeModifierRecord record;
+    record.hashBlock = pindex->GetBlockHash();
+    record.hashKernel = pindex->IsProofOfStake() ? pindex->prevoutStake.hash : pindex->GetBlockHash();
+    record.bnStakeModifier = pindex->bnStakeModifier;
+    record.hashProofOfStake = pindex->hashProofOfStake;
+    return record;
+}
+
+static bool operator==(const CStakeModifierRecord& a, const CStakeModifierRecord& b)
+{
+    return a.hashBlock == b.hashBlock && a.hashKernel == b.hashKernel &&
+           a.bnStakeModifier == b.bnStakeModifier && a.hashProofOfStake == b.hashProofOfStake;
+}
+
+/** Seek to a 64-bit offset from the start of the file */
+static bool SeekFile(FILE* file, uint64_t nPos)
+{
+#ifdef WIN32
+    return _fseeki64(file, nPos, SEEK_SET) == 0;
+#else
+    return fseeko(file, nPos, SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t GetRecordPos(size_t nHeight)
+{
+    return STAKE_MODIFIER_HEADER_SIZE + (uint64_t)nHeight * STAKE_MODIFIER_RECORD_SIZE;
+}
+
+CStakeModifierTable::CStakeModifierTable(const fs::path& pathIn) : path(pathIn), fileRead(nullptr), nRecords(0), nFlushed(0), nFileRecords(0), fHeaderValid(false), nActiveHeight(-1)
+{
+}
+
+CStakeModifierTable::~CStakeModifierTable()
+{
+    if (fileRead)
+        fclose(fileRead);
+}
+
+bool CStakeModifierTable::ReadRecord(size_t nHeight, CStakeModifierRecord& record) const
+{
+    AssertLockHeld(cs);
+    if (nHeight >= nRecords)
+        return false;
+    if (nHeight >= nFlushed) {
+        record = vPending[nHeight - nFlushed];
+        return true;
+    }
+    if (!fileRead) {
+        fileRead = fsbridge::fopen(path, "rb");
+        if (!fileRead)
+            return error("%s: failed to open %s", __func__, path.string());
+    }
+    char buf[STAKE_MODIFIER_RECORD_SIZE];
+    if (!SeekFile(fileRead, GetRecordPos(nHeight)) || fread(buf, 1, sizeof(buf), fileRead) != sizeof(buf))
+        return error("%s: failed to read record %u of %s", __func__, nHeight, path.string());
+    CDataStream ss(buf, buf + sizeof(buf), SER_DISK, CLIENT_VERSION);
+    ss >> record;
+    return true;
+}
+
+void CStakeModifierTable::Append(const CStakeModifierRecord& record)
+{
+    AssertLockHeld(cs);
+    vPending.push_back(record);
+    nRecords++;
+    // Records beyond the flushed chain state are harmless: they are kept
+    // unchecked at the next start, so the pending tail can be written early
+    if (vPending.size() >= STAKE_MODIFIER_MAX_PENDING && !FlushLocked())
+        LogPrintf("%s: failed to write stake modifier table\n", __func__);
+}
+
+void CStakeModifierTable::Truncate(size_t nSize)
+{
+    AssertLockHeld(cs);
+    if (nSize >= nRecords)
+        return;
+    nRecords = nSize;
+    if (nSize < nFlushed) {
+        nFlushed = nSize;
+        vPending.clear();
+    } else {
+        vPending.resize(nSize - nFlushed);
+    }
+}
+
+bool CStakeModifierTable::Load()
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs);
+
+    if (fileRead) {
+        fclose(fileRead);
+        fileRead = nullptr;
+    }
+    vPending.clear();
+    nRecords = nFlushed = nFileRecords = 0;
+    fHeaderValid = false;
+    nActiveHeight = -1;
+
+    FILE* file = fsbridge::fopen(path, "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (!filein.IsNull()) {
+        try {
+            CMessageHeader::MessageStartChars pchMagic;
+            uint32_t nVersion, nRecordSize, nReserved;
+            filein >> FLATDATA(pchMagic) >> nVersion >> nRecordSize >> nReserved;
+            if (memcmp(pchMagic, Params().MessageStart(), sizeof(pchMagic)) == 0 &&
+                nVersion == STAKE_MODIFIER_TABLE_VERSION && nRecordSize == STAKE_MODIFIER_RECORD_SIZE) {
+                fHeaderValid = true;
+                nFileRecords = (fs::file_size(path) - STAKE_MODIFIER_HEADER_SIZE) / STAKE_MODIFIER_RECORD_SIZE;
+            }
+        } catch (const std::exception& e) {
+            LogPrintf("%s: failed to read %s: %s\n", __func__, path.string(), e.what());
+        }
+    }
+    filein.fclose();
+    nRecords = nFlushed = nFileRecords;
+
+    // The table is written as a chain, so the records that agree with the
+    // active chain are a prefix of it, found by bisection. Records beyond
+    // the tip are kept only if all records up to the tip agree; Connect()
+    // checks them as their blocks are connected again.
+    const size_t nCheck = std::min(nFileRecords, (size_t)(chainActive.Height() + 1));
+    size_t nLow = 0, nHigh = nCheck;
+    while (nLow < nHigh) {
+        const size_t nMid = nLow + (nHigh - nLow) / 2;
+        CStakeModifierRecord record;
+        if (ReadRecord(nMid, record) && record == MakeStakeModifierRecord(chainActive[nMid]))
+            nLow = nMid + 1;
+        else
+            nHigh = nMid;
+    }
+    if (nLow < nCheck)
+        nRecords = nFlushed = nLow;
+    LogPrintf("Loaded %u of %u stake modifier table records\n", nRecords, nFileRecords);
+
+    for (int nHeight = nActiveHeight + 1; nHeight <= chainActive.Height(); nHeight++) {
+        if ((size_t)nHeight >= nRecords)
+            Append(MakeStakeModifierRecord(chainActive[nHeight]));
+        nActiveHeight = nHeight;
+    }
+    return true;
+}
+
+bool CStakeModifierTable::FlushLocked()
+{
+    AssertLockHeld(cs);
+    if (fHeaderValid && nFlushed == nFileRecords && vPending.empty())
+        return true;
+
+    if (fileRead) {
+        fclose(fileRead);
+        fileRead = nullptr;
+    }
+    try {
+        // Records past nFlushed are stale on disk: cut them off and append the new ones
+        if (fHeaderValid)
+            fs::resize_file(path, GetRecordPos(nFlushed));
+        FILE* file = fsbridge::fopen(path, fHeaderValid ? "ab" : "wb");
+        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+        if (fileout.IsNull())
+            return error("%s: failed to open %s", __func__, path.string());
+        if (!fHeaderValid)
+            fileout << FLATDATA(Params().MessageStart()) << STAKE_MODIFIER_TABLE_VERSION << STAKE_MODIFIER_RECORD_SIZE << (uint32_t)0;
+        for (const CStakeModifierRecord& record : vPending)
+            fileout << record;
+        FileCommit(fileout.Get());
+    } catch (const std::exception& e) {
+        return error("%s: failed to write %s: %s", __func__, path.string(), e.what());
+    }
+    fHeaderValid = true;
+    nFlushed = nFileRecords = nRecords;
+    vPending.clear();
+    return true;
+}
+
+bool CStakeModifierTable::Flush()
+{
+    LOCK(cs);
+    return FlushLocked();
+}
+
+void CStakeModifierTable::Connect(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    const size_t nHeight = pindex->nHeight;
+    CStakeModifierRecord record = MakeStakeModifierRecord(pindex);
+    CStakeModifierRecord recordOld;
+    // Keep the table as it is when the record is already known, e.g. with -reindex
+    if (!ReadRecord(nHeight, recordOld) || !(recordOld == record)) {
+        Truncate(nHeight);
+        while (nRecords < nHeight)
+            Append(MakeStakeModifierRecord(pindex->GetAncestor(nRecords)));
+        Append(record);
+    }
+    nActiveHeight = pindex->nHeight;
+}
+
+void CStakeModifierTable::Disconnect(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    Truncate(pindex->nHeight);
+    nActiveHeight = pindex->nHeight - 1;
+}
+
+bool CStakeModifierTable::Lookup(int nHeight, CStakeModifierRecord& record) const
+{
+    LOCK(cs);
+    if (nHeight < 0 || nHeight > nActiveHeight)
+        return false;
+    return ReadRecord(nHeight, record);
+}
+
+size_t CStakeModifierTable::Size() const
+{
+    LOCK(cs);
+    return nActiveHeight + 1;
+}
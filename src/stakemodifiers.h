@@ -0,0 +1,118 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#ifndef PULSAR_STAKEMODIFIERS_H
+#define PULSAR_STAKEMODIFIERS_H
+
+#include <fs.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <memory>
+#include <stdio.h>
+#include <vector>
+
+class CBlockIndex;
+
+/** Default for -stakemodifiertable */
+static const bool DEFAULT_STAKEMODIFIERTABLE = false;
+/** Version of the stake modifier table file format */
+static const uint32_t STAKE_MODIFIER_TABLE_VERSION = 1;
+
+/** Stake modifier inputs and outputs of the active chain block at one height */
+struct CStakeModifierRecord
+{
+    uint256 hashBlock;
+    uint256 hashKernel; // block hash for proof-of-work, kernel prevout hash for proof-of-stake
+    uint256 bnStakeModifier;
+    uint256 hashProofOfStake;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(hashKernel);
+        READWRITE(bnStakeModifier);
+        READWRITE(hashProofOfStake);
+    }
+};
+
+/** Size in bytes of one record on disk */
+static const unsigned int STAKE_MODIFIER_RECORD_SIZE = 4 * 32;
+/** Size in bytes of the file header: network magic, version, record size, reserved */
+static const unsigned int STAKE_MODIFIER_HEADER_SIZE = 16;
+/** Number of new records kept in memory before they are appended to the file */
+static const size_t STAKE_MODIFIER_MAX_PENDING = 10000;
+
+/**
+ * Table of the stake modifier of every block of the active chain, indexed by
+ * height. It is stored in stakemodifiers.dat as a fixed-size header followed
+ * by one fixed-size record per height, so the file can be memory-mapped and
+ * looked up in O(1) by external tools. Every record carries the kernel that
+ * went into its modifier, so the modifier at a height can be verified from
+ * that record and the one below it alone, and ranges can be checked in
+ * parallel.
+ *
+ * Only the records not yet written are held in memory; the others are read
+ * from the file on demand.
+ *
+ * Records beyond the active tip are kept, unchecked, as long as the records
+ * up to the tip agree with the active chain. Connecting a block compares it
+ * with the record at its height and only rewrites the table from there on a
+ * mismatch, so that -reindex and -reindex-chainstate find the records again
+ * instead of rewriting the table.
+ */
+class CStakeModifierTable
+{
+private:
+    mutable CCriticalSection cs;
+    fs::path path;
+    //! Handle for reading records, reopened after every write
+    mutable FILE* fileRead;
+    //! Number of records in the table, including unchecked ones beyond the active tip
+    size_t nRecords;
+    //! Number of records at the start of the table that are already on disk
+    size_t nFlushed;
+    //! Records from nFlushed on, not yet on disk
+    std::vector<CStakeModifierRecord> vPending;
+    //! Number of records in the file on disk, including stale ones
+    size_t nFileRecords;
+    //! Whether the file on disk has a valid header
+    bool fHeaderValid;
+    //! Height of the active tip, the last record Lookup() returns
+    int nActiveHeight;
+
+    bool ReadRecord(size_t nHeight, CStakeModifierRecord& record) const;
+    void Append(const CStakeModifierRecord& record);
+    void Truncate(size_t nSize);
+    bool FlushLocked();
+
+public:
+    explicit CStakeModifierTable(const fs::path& pathIn);
+    ~CStakeModifierTable();
+    CStakeModifierTable(const CStakeModifierTable&) = delete;
+    CStakeModifierTable& operator=(const CStakeModifierTable&) = delete;
+
+    /** Open the table on disk, keeping the records that agree with the active
+     *  chain and those beyond its tip, and append the rest of the active
+     *  chain. Requires cs_main. */
+    bool Load();
+    /** Write the records that changed since the last flush */
+    bool Flush();
+
+    /** Record pindex as the block of the active chain at its height */
+    void Connect(const CBlockIndex* pindex);
+    /** Forget pindex and any records above it */
+    void Disconnect(const CBlockIndex* pindex);
+
+    /** Look up the record of the active chain at nHeight */
+    bool Lookup(int nHeight, CStakeModifierRecord& record) const;
+    /** Number of records of the active chain */
+    size_t Size() const;
+};
+
+extern std::unique_ptr<CStakeModifierTable> pstakemodifiers;
+
+#endif // PULSAR_STAKEMODIFIERS_H
@@ -0,0 +1,162 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <supplyindex.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <undo.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/thread.hpp>
+
+static const char DB_SUPPLY_STATS = 's';
+static const char DB_BEST_BLOCK = 'B';
+
+const std::string SUPPLY_TYPE_NAMES[SUPPLY_TYPES] = {"pos", "curvehash", "minotaurx"};
+
+std::unique_ptr<CSupplyIndex> g_supplyindex;
+
+static SupplyType GetSupplyType(const CBlockIndex* pindex)
+{
+    if (pindex->IsProofOfStake())
+        return SUPPLY_POS;
+    return pindex->GetPoWType() == POW_TYPE_MINOTAURX ? SUPPLY_MINOTAURX : SUPPLY_CURVEHASH;
+}
+
+void CSupplyStats::SetNull()
+{
+    hashBlock.SetNull();
+    nType = 0;
+    nMoneySupply = nMint = nFeesBurned = nStaked = 0;
+    for (int i = 0; i < SUPPLY_TYPES; i++) {
+        nBlocksTotal[i] = 0;
+        nMintTotal[i] = 0;
+    }
+    nFeesBurnedTotal = nStakedTotal = 0;
+}
+
+CSupplyIndex::CSupplyIndex(size_t nCacheSize, bool fMemory, bool fWipe) :
+    db(GetDataDir() / "indexes" / "supply", nCacheSize, fMemory, fWipe), fSynced(false)
+{
+}
+
+bool CSupplyIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Running totals continue from the parent's record
+    CSupplyStats stats;
+    if (pindex->pprev && (!db.Read(std::make_pair(DB_SUPPLY_STATS, pindex->nHeight - 1), stats) || stats.hashBlock != pindex->pprev->GetBlockHash()))
+        return error("%s: no supply index entry for the parent of block %s", __func__, pindex->GetBlockHash().ToString());
+
+    stats.hashBlock = pindex->GetBlockHash();
+    stats.nType = GetSupplyType(pindex);
+    {
+        LOCK(cs_main);
+        stats.nMoneySupply = pindex->nMoneySupply;
+        stats.nMint = pindex->nMint;
+    }
+    stats.nFeesBurned = 0;
+    stats.nStaked = 0;
+    if (pindex->pprev) { // the genesis block has no undo data
+        CBlockUndo blockundo;
+        if (!UndoReadFromDisk(blockundo, pindex))
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        if (blockundo.vtxundo.size() + 1 != block.vtx.size())
+            return error("%s: undo data does not match block %s", __func__, pindex->GetBlockHash().ToString());
+        for (size_t i = 1; i < block.vtx.size(); i++) {
+            CAmount nValueIn = 0;
+            for (const Coin& coin : blockundo.vtxundo[i - 1].vprevout)
+                nValueIn += coin.out.nValue;
+            if (block.vtx[i]->IsCoinStake())
+                stats.nStaked += nValueIn;
+            else
+                stats.nFeesBurned += nValueIn - block.vtx[i]->GetValueOut();
+        }
+    }
+    stats.nBlocksTotal[stats.nType]++;
+    stats.nMintTotal[stats.nType] += stats.nMint;
+    stats.nFeesBurnedTotal += stats.nFeesBurned;
+    stats.nStakedTotal += stats.nStaked;
+
+    CDBBatch batch(db);
+    batch.Write(std::make_pair(DB_SUPPLY_STATS, pindex->nHeight), stats);
+    batch.Write(DB_BEST_BLOCK, stats.hashBlock);
+    return db.WriteBatch(batch);
+}
+
+void CSupplyIndex::ThreadSync()
+{
+    RenameThread("pulsar-supplyidx");
+    const Consensus::Params& params = Params().GetConsensus();
+
+    // Last block of the active chain that is indexed
+    const CBlockIndex* pindex = nullptr;
+    {
+        LOCK(cs_main);
+        uint256 hashBest;
+        if (db.Read(DB_BEST_BLOCK, hashBest)) {
+            BlockMap::const_iterator mi = mapBlockIndex.find(hashBest);
+            if (mi != mapBlockIndex.end())
+                pindex = chainActive.FindFork(mi->second);
+        }
+        LogPrintf("%s: supply index synced up to height %d\n", __func__, pindex ? pindex->nHeight : -1);
+    }
+
+    int64_t nLastLog = GetTime();
+    while (true) {
+        boost::this_thread::interruption_point();
+        const CBlockIndex* pindexNext;
+        {
+            LOCK(cs_main);
+            if (pindex && !chainActive.Contains(pindex))
+                pindex = chainActive.FindFork(pindex);
+            pindexNext = pindex ? chainActive.Next(pindex) : chainActive.Genesis();
+            if (!pindexNext) {
+                // Caught up while holding cs_main: blocks connected from now
+                // on are indexed through BlockConnected
+                fSynced = true;
+                LogPrintf("%s: supply index is up to date at height %d\n", __func__, pindex ? pindex->nHeight : -1);
+                return;
+            }
+        }
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindexNext, params) || !WriteBlock(block, pindexNext)) {
+            LogPrintf("%s: failed to index block %s, supply index stopped\n", __func__, pindexNext->GetBlockHash().ToString());
+            return;
+        }
+        pindex = pindexNext;
+        if (GetTime() >= nLastLog + 30) {
+            LogPrintf("%s: supply index synced up to height %d\n", __func__, pindex->nHeight);
+            nLastLog = GetTime();
+        }
+    }
+}
+
+void CSupplyIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted)
+{
+    if (!fSynced)
+        return;
+    if (!WriteBlock(*block, pindex))
+        LogPrintf("%s: failed to index block %s\n", __func__, pindex->GetBlockHash().ToString());
+}
+
+void CSupplyIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    if (!fSynced)
+        return;
+    // Records are keyed by height and carry their block hash, so the ones above
+    // the new tip are simply overwritten when the chain moves on
+    db.Write(DB_BEST_BLOCK, block->hashPrevBlock);
+}
+
+bool CSupplyIndex::Lookup(int nHeight, CSupplyStats& stats) const
+{
+    AssertLockHeld(cs_main);
+    if (nHeight < 0 || nHeight > chainActive.Height())
+        return false;
+    return db.Read(std::make_pair(DB_SUPPLY_STATS, nHeight), stats) && stats.hashBlock == chainActive[nHeight]->GetBlockHash();
+}
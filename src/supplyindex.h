@@ -0,0 +1,110 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#ifndef PULSAR_SUPPLYINDEX_H
+#define PULSAR_SUPPLYINDEX_H
+
+#include <amount.h>
+#include <dbwrapper.h>
+#include <serialize.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+class CBlock;
+class CBlockIndex;
+
+/** Default for -supplyindex */
+static const bool DEFAULT_SUPPLYINDEX = false;
+/** Database cache size of the supply index */
+static const size_t SUPPLYINDEX_CACHE_SIZE = 8 << 20;
+
+/** Block kinds the supply index splits minting by */
+enum SupplyType {
+    SUPPLY_POS,
+    SUPPLY_CURVEHASH,
+    SUPPLY_MINOTAURX,
+    SUPPLY_TYPES
+};
+extern const std::string SUPPLY_TYPE_NAMES[SUPPLY_TYPES];
+
+/**
+ * Supply and minting statistics of one block of the active chain, along with
+ * their running totals from the genesis block up to and including it. Totals
+ * over any range of heights are the difference of two records.
+ */
+struct CSupplyStats
+{
+    uint256 hashBlock;
+    uint8_t nType;
+    CAmount nMoneySupply;
+    CAmount nMint;
+    //! Fees of the block's transactions, which are destroyed
+    CAmount nFeesBurned;
+    //! Value of the coinstake inputs, zero for proof-of-work blocks
+    CAmount nStaked;
+
+    uint32_t nBlocksTotal[SUPPLY_TYPES];
+    CAmount nMintTotal[SUPPLY_TYPES];
+    CAmount nFeesBurnedTotal;
+    CAmount nStakedTotal;
+
+    CSupplyStats() { SetNull(); }
+
+    void SetNull();
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(nType);
+        READWRITE(nMoneySupply);
+        READWRITE(nMint);
+        READWRITE(nFeesBurned);
+        READWRITE(nStaked);
+        for (int i = 0; i < SUPPLY_TYPES; i++) {
+            READWRITE(nBlocksTotal[i]);
+            READWRITE(nMintTotal[i]);
+        }
+        READWRITE(nFeesBurnedTotal);
+        READWRITE(nStakedTotal);
+    }
+};
+
+/**
+ * Optional index of CSupplyStats by height (-supplyindex), kept in
+ * indexes/supply. On startup a background thread builds it from the block
+ * index, the block files and the undo files up to the active tip; from then
+ * on it follows BlockConnected/BlockDisconnected.
+ */
+class CSupplyIndex : public CValidationInterface
+{
+private:
+    CDBWrapper db;
+    //! Whether the background sync reached the active tip
+    std::atomic<bool> fSynced;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+public:
+    CSupplyIndex(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    /** Catch up with the active chain, then hand over to the validation interface */
+    void ThreadSync();
+
+    bool IsSynced() const { return fSynced; }
+    /** Read the record at nHeight, if it belongs to the active chain. Requires cs_main. */
+    bool Lookup(int nHeight, CSupplyStats& stats) const;
+};
+
+extern std::unique_ptr<CSupplyIndex> g_supplyindex;
+
+#endif // PULSAR_SUPPLYINDEX_H
@@ -0,0 +1,87 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PULSAR_TEST_BLOCKINDEXCHAIN_H
+#define PULSAR_TEST_BLOCKINDEXCHAIN_H
+
+#include <chain.h>
+#include <random.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validation.h>
+
+#include <deque>
+
+/**
+ * Block index entries without blocks behind them, for the tests of code that
+ * walks the block tree. Entries keep their addresses as more are added, and
+ * may branch off any earlier entry.
+ */
+struct CTestBlockIndexChain
+{
+    std::deque<uint256> vHashes;
+    std::deque<CBlockIndex> vBlocks;
+
+    CTestBlockIndexChain() {}
+
+    /** A chain of nLength entries from height 0, with random hashes */
+    explicit CTestBlockIndexChain(int nLength)
+    {
+        for (int i = 0; i < nLength; i++)
+            Add(Tip(), GetRandHash());
+    }
+
+    CTestBlockIndexChain(const CTestBlockIndexChain&) = delete;
+    CTestBlockIndexChain& operator=(const CTestBlockIndexChain&) = delete;
+
+    /** Add an entry on top of pprev, or a genesis for nullptr, linked through
+     *  pprev and the skip list. Fields the skip list does not depend on are
+     *  left to the caller. */
+    CBlockIndex& Add(CBlockIndex* pprev, const uint256& hash)
+    {
+        vHashes.push_back(hash);
+        vBlocks.emplace_back();
+        CBlockIndex& block = vBlocks.back();
+        block.phashBlock = &vHashes.back();
+        block.pprev = pprev;
+        block.nHeight = pprev ? pprev->nHeight + 1 : 0;
+        block.BuildSkip();
+        return block;
+    }
+
+    CBlockIndex* Tip() { return vBlocks.empty() ? nullptr : &vBlocks.back(); }
+    CBlockIndex& operator[](size_t i) { return vBlocks[i]; }
+    size_t size() const { return vBlocks.size(); }
+};
+
+/**
+ * Swaps the entries of a CTestBlockIndexChain in for the contents of
+ * mapBlockIndex, for code that looks blocks up by hash, and the previous
+ * contents back on destruction.
+ */
+class CTestBlockIndexMapScope
+{
+private:
+    BlockMap mapSaved;
+
+public:
+    explicit CTestBlockIndexMapScope(CTestBlockIndexChain& chain)
+    {
+        LOCK(cs_main);
+        mapBlockIndex.swap(mapSaved);
+        for (CBlockIndex& block : chain.vBlocks)
+            mapBlockIndex.emplace(block.GetBlockHash(), &block);
+    }
+
+    ~CTestBlockIndexMapScope()
+    {
+        LOCK(cs_main);
+        mapBlockIndex.swap(mapSaved);
+    }
+
+    CTestBlockIndexMapScope(const CTestBlockIndexMapScope&) = delete;
+    CTestBlockIndexMapScope& operator=(const CTestBlockIndexMapScope&) = delete;
+};
+
+#endif // PULSAR_TEST_BLOCKINDEXCHAIN_H
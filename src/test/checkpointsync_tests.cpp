@@ -0,0 +1,97 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <checkpointsync.h>
+#include <test/blockindexchain.h>
+#include <test/test_bitcoin.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+static const int MAIN_LENGTH = 200;
+static const int FORK_HEIGHT = 50;
+static const int FORK_LENGTH = 100;
+static const int SYNC_CHECKPOINT_HEIGHT = 100;
+
+// A main chain and a branch forking off below the sync-checkpoint, as the
+// block index, with the sync-checkpoint on the main chain
+struct SyncCheckpointTestingSetup : public BasicTestingSetup
+{
+    CTestBlockIndexChain chain;
+    CTestBlockIndexMapScope mapScope;
+    uint256 hashSyncCheckpointOld;
+
+    SyncCheckpointTestingSetup() : chain(MAIN_LENGTH), mapScope(chain)
+    {
+        for (int i = 0; i < FORK_LENGTH; i++)
+            chain.Add(i ? chain.Tip() : &chain[FORK_HEIGHT], InsecureRand256());
+        hashSyncCheckpointOld = hashSyncCheckpoint;
+        hashSyncCheckpoint = chain[SYNC_CHECKPOINT_HEIGHT].GetBlockHash();
+    }
+
+    ~SyncCheckpointTestingSetup()
+    {
+        hashSyncCheckpoint = hashSyncCheckpointOld;
+    }
+
+    CBlockIndex* Main(int nHeight) { return &chain[nHeight]; }
+    CBlockIndex* Fork(int nHeight) { return &chain[MAIN_LENGTH + nHeight - FORK_HEIGHT - 1]; }
+};
+
+BOOST_FIXTURE_TEST_SUITE(checkpointsync_tests, SyncCheckpointTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sync_checkpoint_descendant)
+{
+    LOCK(cs_main);
+    const CBlockIndex* pindexSync = Main(SYNC_CHECKPOINT_HEIGHT);
+    BOOST_CHECK(CheckSyncCheckpoint(Main(SYNC_CHECKPOINT_HEIGHT + 1)->GetBlockHash(), pindexSync));
+    BOOST_CHECK(CheckSyncCheckpoint(Main(MAIN_LENGTH - 1)->GetBlockHash(), Main(MAIN_LENGTH - 2)));
+    BOOST_CHECK(Main(MAIN_LENGTH - 2)->pindexSyncCheckpoint == pindexSync);
+    BOOST_CHECK(IsDescendantOfSyncCheckpoint(pindexSync, pindexSync));
+}
+
+BOOST_AUTO_TEST_CASE(sync_checkpoint_not_descendant)
+{
+    LOCK(cs_main);
+    const CBlockIndex* pindexSync = Main(SYNC_CHECKPOINT_HEIGHT);
+
+    // Headers above the checkpoint on a branch that forked off below it
+    for (int nHeight = SYNC_CHECKPOINT_HEIGHT + 1; nHeight <= FORK_HEIGHT + FORK_LENGTH; nHeight++) {
+        BOOST_CHECK(!CheckSyncCheckpoint(Fork(nHeight)->GetBlockHash(), Fork(nHeight - 1)));
+        BOOST_CHECK(!IsDescendantOfSyncCheckpoint(Fork(nHeight), pindexSync));
+    }
+    BOOST_CHECK(Fork(FORK_HEIGHT + FORK_LENGTH)->pindexSyncCheckpoint == nullptr);
+
+    // Blocks below the checkpoint never descend from it, even on its chain
+    BOOST_CHECK(!IsDescendantOfSyncCheckpoint(Main(SYNC_CHECKPOINT_HEIGHT - 1), pindexSync));
+
+    // A cached checkpoint only answers for that checkpoint: once the main
+    // chain is cached, a later checkpoint on the branch still rejects it
+    BOOST_CHECK(CheckSyncCheckpoint(Main(MAIN_LENGTH - 1)->GetBlockHash(), Main(MAIN_LENGTH - 2)));
+    hashSyncCheckpoint = Fork(SYNC_CHECKPOINT_HEIGHT + 10)->GetBlockHash();
+    BOOST_CHECK(!CheckSyncCheckpoint(Main(MAIN_LENGTH - 1)->GetBlockHash(), Main(MAIN_LENGTH - 2)));
+    BOOST_CHECK(CheckSyncCheckpoint(Fork(SYNC_CHECKPOINT_HEIGHT + 20)->GetBlockHash(), Fork(SYNC_CHECKPOINT_HEIGHT + 19)));
+}
+
+BOOST_AUTO_TEST_CASE(sync_checkpoint_same_height)
+{
+    LOCK(cs_main);
+    // Only the checkpoint itself is accepted at its height
+    BOOST_CHECK(CheckSyncCheckpoint(Main(SYNC_CHECKPOINT_HEIGHT)->GetBlockHash(), Main(SYNC_CHECKPOINT_HEIGHT - 1)));
+    BOOST_CHECK(!CheckSyncCheckpoint(InsecureRand256(), Main(SYNC_CHECKPOINT_HEIGHT - 1)));
+    BOOST_CHECK(!CheckSyncCheckpoint(Fork(SYNC_CHECKPOINT_HEIGHT)->GetBlockHash(), Fork(SYNC_CHECKPOINT_HEIGHT - 1)));
+}
+
+BOOST_AUTO_TEST_CASE(sync_checkpoint_below)
+{
+    LOCK(cs_main);
+    // Below the checkpoint, only blocks already in the block index are accepted
+    BOOST_CHECK(CheckSyncCheckpoint(Main(FORK_HEIGHT)->GetBlockHash(), Main(FORK_HEIGHT - 1)));
+    BOOST_CHECK(CheckSyncCheckpoint(Fork(SYNC_CHECKPOINT_HEIGHT - 1)->GetBlockHash(), Fork(SYNC_CHECKPOINT_HEIGHT - 2)));
+    BOOST_CHECK(!CheckSyncCheckpoint(InsecureRand256(), Main(FORK_HEIGHT - 1)));
+    BOOST_CHECK(!CheckSyncCheckpoint(InsecureRand256(), Fork(SYNC_CHECKPOINT_HEIGHT - 2)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
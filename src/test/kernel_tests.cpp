@@ -0,0 +1,152 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <amount.h>
+#include <arith_uint256.h>
+#include <hash.h>
+#include <kernel.h>
+#include <chain.h>
+#include <stakemodifiers.h>
+#include <validation.h>
+#include <streams.h>
+#include <test/blockindexchain.h>
+#include <test/test_bitcoin.h>
+#include <bignum.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(kernel_tests, BasicTestingSetup)
+
+/* The kernel check as it was done with CBigNum */
+static bool CheckKernelTargetBigNum(unsigned int nBits, CAmount nValueIn, const uint256& hashProofOfStake)
+{
+    CBigNum bnTarget;
+    bnTarget.SetCompact(nBits);
+    bnTarget *= CBigNum(nValueIn);
+    return !(CBigNum(hashProofOfStake) > bnTarget);
+}
+
+static bool CheckKernelTarget(unsigned int nBits, CAmount nValueIn, const uint256& hashProofOfStake)
+{
+    arith_uint256 bnTarget;
+    bool fAnyHash;
+    if (!GetStakeKernelTarget(nBits, nValueIn, bnTarget, fAnyHash))
+        return false;
+    return fAnyHash || UintToArith256(hashProofOfStake) <= bnTarget;
+}
+
+static void CheckKernelTargetAround(unsigned int nBits, CAmount nValueIn)
+{
+    // Hashes right at and around the weighted target, and random ones
+    CBigNum bnTarget;
+    bnTarget.SetCompact(nBits);
+    bnTarget *= CBigNum(nValueIn);
+    arith_uint256 target = UintToArith256(bnTarget.getuint256());
+    std::vector<uint256> vHashes = {uint256(), ArithToUint256(~arith_uint256()), ArithToUint256(target),
+                                    ArithToUint256(target + 1), ArithToUint256(target - 1), InsecureRand256()};
+    for (const uint256& hash : vHashes)
+        BOOST_CHECK_MESSAGE(CheckKernelTarget(nBits, nValueIn, hash) == CheckKernelTargetBigNum(nBits, nValueIn, hash),
+                            strprintf("nBits=%08x nValueIn=%d hash=%s", nBits, nValueIn, hash.ToString()));
+}
+
+BOOST_AUTO_TEST_CASE(kernel_target_matches_bignum)
+{
+    // Targets and amounts seen on chain, and the edges of both
+    const std::vector<unsigned int> vBits = {0x1e0fffff, 0x1d00ffff, 0x1c0ffff0, 0x1b0404cb, 0x207fffff, 0x1f00ffff,
+                                             0x21000001, 0x2100ffff, 0x22000001, 0x01003456, 0x02008000, 0x03123456,
+                                             0x04923456, 0x1d80ffff, 0x00000000, 0x2300ffff, 0xff123456};
+    const std::vector<CAmount> vValues = {0, 1, CENT, COIN, 1234 * COIN + 5678, 100000 * COIN, MAX_MONEY,
+                                          std::numeric_limits<int64_t>::max(), -1, -COIN};
+    for (unsigned int nBits : vBits)
+        for (CAmount nValue : vValues)
+            CheckKernelTargetAround(nBits, nValue);
+
+    for (int i = 0; i < 2000; i++) {
+        unsigned int nBits = (InsecureRandRange(0x24) << 24) | InsecureRandBits(24);
+        CAmount nValue = InsecureRandRange(MAX_MONEY + 1);
+        CheckKernelTargetAround(nBits, nValue);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kernel_hash_matches_serialization)
+{
+    for (int i = 0; i < 100; i++) {
+        uint256 bnStakeModifier = InsecureRand256();
+        unsigned int nTimeTxPrev = InsecureRand32();
+        COutPoint prevout(InsecureRand256(), InsecureRand32());
+        unsigned int nTimeTx = InsecureRand32();
+
+        CDataStream ss(SER_GETHASH, 0);
+        ss << bnStakeModifier;
+        ss << nTimeTxPrev << prevout.hash << prevout.n << nTimeTx;
+        BOOST_CHECK(GetStakeKernelHash(bnStakeModifier, nTimeTxPrev, prevout, nTimeTx) == Hash(ss.begin(), ss.end()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stake_modifier_table)
+{
+    const int nBlocks = 10;
+    CTestBlockIndexChain chain(nBlocks);
+    for (int i = 0; i < nBlocks; i++) {
+        chain[i].bnStakeModifier = ComputeStakeModifier(chain[i].pprev, chain.vHashes[i]);
+        if (i)
+            BOOST_CHECK(chain[i].bnStakeModifier == ComputeStakeModifier(chain[i - 1].bnStakeModifier, chain.vHashes[i]));
+    }
+
+    fs::path path = fs::temp_directory_path() / fs::unique_path("stakemodifiers_%%%%%%%%.dat");
+    CStakeModifierTable table(path);
+    CStakeModifierRecord record;
+    for (int i = 0; i < nBlocks; i++)
+        table.Connect(&chain[i]);
+    BOOST_CHECK_EQUAL((int)table.Size(), nBlocks);
+    BOOST_CHECK(table.Lookup(7, record));
+    BOOST_CHECK(record.hashBlock == chain.vHashes[7] && record.hashKernel == chain.vHashes[7]);
+    BOOST_CHECK(record.bnStakeModifier == chain[7].bnStakeModifier);
+    BOOST_CHECK(!table.Lookup(nBlocks, record));
+
+    // Disconnecting truncates the table, reconnecting appends again
+    table.Disconnect(&chain[nBlocks - 1]);
+    BOOST_CHECK_EQUAL((int)table.Size(), nBlocks - 1);
+    BOOST_CHECK(table.Flush());
+    BOOST_CHECK_EQUAL(fs::file_size(path), STAKE_MODIFIER_HEADER_SIZE + (nBlocks - 1) * STAKE_MODIFIER_RECORD_SIZE);
+    table.Connect(&chain[nBlocks - 1]);
+    BOOST_CHECK(table.Flush());
+    BOOST_CHECK_EQUAL(fs::file_size(path), STAKE_MODIFIER_HEADER_SIZE + nBlocks * STAKE_MODIFIER_RECORD_SIZE);
+
+    BOOST_CHECK(table.Lookup(7, record));
+    BOOST_CHECK(record.hashBlock == chain.vHashes[7] && record.bnStakeModifier == chain[7].bnStakeModifier);
+
+    // Loading with an empty active chain, as with -reindex, keeps the records
+    // unchecked; connecting the blocks again only rewrites those that differ
+    LOCK(cs_main);
+    CStakeModifierTable table2(path);
+    table2.Load();
+    BOOST_CHECK_EQUAL((int)table2.Size(), 0);
+    BOOST_CHECK(!table2.Lookup(0, record));
+    chain[5].bnStakeModifier = InsecureRand256();
+    for (int i = 0; i < nBlocks; i++)
+        table2.Connect(&chain[i]);
+    BOOST_CHECK_EQUAL((int)table2.Size(), nBlocks);
+    BOOST_CHECK(table2.Lookup(5, record) && record.bnStakeModifier == chain[5].bnStakeModifier);
+    BOOST_CHECK(table2.Flush());
+    BOOST_CHECK_EQUAL(fs::file_size(path), STAKE_MODIFIER_HEADER_SIZE + nBlocks * STAKE_MODIFIER_RECORD_SIZE);
+
+    // Loading with an active chain keeps the records that agree with it and
+    // replaces the others
+    chainActive.SetTip(chain.Tip());
+    CStakeModifierTable table3(path);
+    table3.Load();
+    BOOST_CHECK_EQUAL((int)table3.Size(), nBlocks);
+    BOOST_CHECK(table3.Lookup(5, record) && record.bnStakeModifier == chain[5].bnStakeModifier);
+    chain[8].bnStakeModifier = InsecureRand256();
+    table3.Load();
+    BOOST_CHECK_EQUAL((int)table3.Size(), nBlocks);
+    BOOST_CHECK(table3.Lookup(8, record) && record.bnStakeModifier == chain[8].bnStakeModifier);
+    BOOST_CHECK(table3.Flush());
+    BOOST_CHECK_EQUAL(fs::file_size(path), STAKE_MODIFIER_HEADER_SIZE + nBlocks * STAKE_MODIFIER_RECORD_SIZE);
+    chainActive.SetTip(nullptr);
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
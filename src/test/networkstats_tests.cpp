@@ -0,0 +1,103 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <networkstats.h>
+#include <test/blockindexchain.h>
+#include <test/test_bitcoin.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(networkstats_tests, BasicTestingSetup)
+
+// Estimates of one stream, walking back from the tip as the RPCs used to
+static CBlockStreamStats GetStreamStatsSlow(const CBlockIndex* pindexTip, int nStream, unsigned int nWindow)
+{
+    std::vector<const CBlockIndex*> vBlocks;
+    for (const CBlockIndex* pindex = pindexTip; pindex && vBlocks.size() < nWindow; pindex = pindex->pprev) {
+        int nBlockStream = pindex->IsProofOfStake() ? NETSTATS_POS : pindex->GetPoWType() == POW_TYPE_MINOTAURX ? NETSTATS_MINOTAURX : NETSTATS_CURVEHASH;
+        if (nBlockStream == nStream)
+            vBlocks.push_back(pindex);
+    }
+    CBlockStreamStats stream;
+    stream.nBlocks = vBlocks.size();
+    if (vBlocks.empty())
+        return stream;
+    stream.nHeight = vBlocks.front()->nHeight;
+    arith_uint256 work;
+    for (size_t i = 0; i + 1 < vBlocks.size(); i++)
+        work += nStream == NETSTATS_POS ? GetBlockProof(*vBlocks[i]) : GetBlockProof(*vBlocks[i], vBlocks[i]->GetPoWType());
+    int64_t nTimeSpan = vBlocks.front()->GetBlockTime() - vBlocks.back()->GetBlockTime();
+    if (vBlocks.size() > 1 && nTimeSpan > 0)
+        stream.dRate = work.getdouble() / nTimeSpan;
+    return stream;
+}
+
+static void CheckNetworkStats(const CNetworkStatsEstimator& estimator, const CBlockIndex* pindexTip, unsigned int nWindow)
+{
+    CNetworkStats stats = estimator.GetStats();
+    BOOST_CHECK_EQUAL(stats.nHeight, pindexTip->nHeight);
+    BOOST_CHECK(stats.hashBlock == pindexTip->GetBlockHash());
+    for (int s = 0; s < NETSTATS_STREAMS; s++) {
+        CBlockStreamStats expected = GetStreamStatsSlow(pindexTip, s, nWindow);
+        BOOST_CHECK_EQUAL(stats.streams[s].nBlocks, expected.nBlocks);
+        BOOST_CHECK_EQUAL(stats.streams[s].nHeight, expected.nHeight);
+        BOOST_CHECK_EQUAL(stats.streams[s].dRate, expected.dRate);
+    }
+}
+
+/* The rolling estimates match a walk back from the tip, across reorganizations */
+BOOST_AUTO_TEST_CASE(network_stats_estimator)
+{
+    const unsigned int nWindow = 10;
+    const int nMainBlocks = 300, nForkHeight = 250, nForkBlocks = 100;
+    const int64_t nTimeStart = Params().GetConsensus().powForkTime + 1000;
+    CTestBlockIndexChain chain;
+    for (int i = 0; i < nMainBlocks + nForkBlocks; i++) {
+        bool fFork = i >= nMainBlocks;
+        CBlockIndex& block = chain.Add(i == nMainBlocks ? &chain[nForkHeight] : chain.Tip(), InsecureRand256());
+        block.nTime = nTimeStart + block.nHeight * 60 + InsecureRandRange(120);
+        block.nBits = 0x1d00ffff - InsecureRandRange(0x8000);
+        // Streams interleave irregularly, the fork branch has no minotaurx blocks.
+        // Proof-of-stake blocks carry either PoW type in their version.
+        int nType = InsecureRandRange(fFork ? 2 : 3);
+        if (nType == 0) {
+            block.SetProofOfStake();
+            block.nVersion = (InsecureRandBool() ? POW_TYPE_MINOTAURX : POW_TYPE_CURVEHASH) << 16;
+        } else {
+            block.nVersion = (nType == 2 ? POW_TYPE_MINOTAURX : POW_TYPE_CURVEHASH) << 16;
+        }
+        block.SetBlockType();
+        block.BuildPrevSameType();
+    }
+    const CBlockIndex* pindexMainTip = &chain[nMainBlocks - 1];
+    const CBlockIndex* pindexForkTip = chain.Tip();
+
+    CNetworkStatsEstimator estimator(nWindow);
+    BOOST_CHECK_EQUAL(estimator.GetStats().nHeight, -1);
+
+    // Startup fills the windows backwards, later tips only add their blocks
+    estimator.Update(&chain[200]);
+    CheckNetworkStats(estimator, &chain[200], nWindow);
+    for (int i = 201; i < nMainBlocks; i += 7) {
+        estimator.Update(&chain[i]);
+        CheckNetworkStats(estimator, &chain[i], nWindow);
+    }
+    estimator.Update(pindexMainTip);
+    CheckNetworkStats(estimator, pindexMainTip, nWindow);
+
+    // Reorganizations both ways, and a tip that only disconnects
+    estimator.Update(pindexForkTip);
+    CheckNetworkStats(estimator, pindexForkTip, nWindow);
+    estimator.Update(&chain[nForkHeight]);
+    CheckNetworkStats(estimator, &chain[nForkHeight], nWindow);
+    estimator.Update(pindexMainTip);
+    CheckNetworkStats(estimator, pindexMainTip, nWindow);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
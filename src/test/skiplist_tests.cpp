@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <util.h>
+#include <test/blockindexchain.h>
 #include <test/test_bitcoin.h>
 
 #include <vector>
@@ -177,4 +178,26 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_edge_test)
     BOOST_CHECK(!chain.FindEarliestAtLeast(int64_t(std::numeric_limits<unsigned int>::max()) + 1));
 }
 
+BOOST_AUTO_TEST_CASE(prevsametype_test)
+{
+    CTestBlockIndexChain chain(10000);
+
+    for (int i = 0; i < 10000; i++) {
+        if (InsecureRandBool())
+            chain[i].SetProofOfStake();
+        else {
+            chain[i].nVersion = (InsecureRandBool() ? POW_TYPE_MINOTAURX : POW_TYPE_CURVEHASH) << 16;
+            chain[i].SetBlockType();
+        }
+        chain[i].BuildPrevSameType();
+    }
+
+    for (int i = 0; i < 10000; i++) {
+        const CBlockIndex* pindex = chain[i].pprev;
+        while (pindex && (pindex->IsProofOfStake() != chain[i].IsProofOfStake() || pindex->GetBlockHeader().GetPoWType() != chain[i].GetPoWType()))
+            pindex = pindex->pprev;
+        BOOST_CHECK(chain[i].pprevSameType == pindex);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
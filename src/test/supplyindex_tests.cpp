@@ -0,0 +1,106 @@
+// Copyright (c) 2022 The Pulsar developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <amount.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <script/interpreter.h>
+#include <supplyindex.h>
+#include <test/test_bitcoin.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(supplyindex_tests, TestChain100Setup)
+
+// Every record of the active chain matches its block and continues the running
+// totals of the record below it
+static void CheckSupplyTotals(const CSupplyIndex& index)
+{
+    LOCK(cs_main);
+    CSupplyStats prev;
+    for (int nHeight = 0; nHeight <= chainActive.Height(); nHeight++) {
+        const CBlockIndex* pindex = chainActive[nHeight];
+        CSupplyStats stats;
+        BOOST_REQUIRE(index.Lookup(nHeight, stats));
+        BOOST_CHECK(stats.hashBlock == pindex->GetBlockHash());
+        BOOST_CHECK_EQUAL(stats.nMoneySupply, pindex->nMoneySupply);
+        BOOST_CHECK_EQUAL(stats.nMint, pindex->nMint);
+        for (int i = 0; i < SUPPLY_TYPES; i++) {
+            BOOST_CHECK_EQUAL(stats.nBlocksTotal[i], prev.nBlocksTotal[i] + (i == stats.nType ? 1 : 0));
+            BOOST_CHECK_EQUAL(stats.nMintTotal[i], prev.nMintTotal[i] + (i == stats.nType ? stats.nMint : 0));
+        }
+        BOOST_CHECK_EQUAL(stats.nFeesBurnedTotal, prev.nFeesBurnedTotal + stats.nFeesBurned);
+        BOOST_CHECK_EQUAL(stats.nStakedTotal, prev.nStakedTotal + stats.nStaked);
+        prev = stats;
+    }
+    CSupplyStats stats;
+    BOOST_CHECK(!index.Lookup(chainActive.Height() + 1, stats));
+}
+
+static CAmount GetFeesBurnedTotal(const CSupplyIndex& index)
+{
+    LOCK(cs_main);
+    CSupplyStats stats;
+    BOOST_REQUIRE(index.Lookup(chainActive.Height(), stats));
+    return stats.nFeesBurnedTotal;
+}
+
+BOOST_AUTO_TEST_CASE(supplyindex_connect_disconnect)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Sync up with the existing chain, then follow it through the validation interface
+    CSupplyIndex index(1 << 20, true, true);
+    index.ThreadSync();
+    BOOST_CHECK(index.IsSynced());
+    RegisterValidationInterface(&index);
+    CheckSupplyTotals(index);
+    BOOST_CHECK_EQUAL(GetFeesBurnedTotal(index), 0);
+
+    // A block with a transaction whose fee is destroyed
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbaseTxns[0].GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11 * CENT;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, spend, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+    const CAmount nFee = coinbaseTxns[0].vout[0].nValue - spend.vout[0].nValue;
+
+    CBlock block = CreateAndProcessBlock({spend}, scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    SyncWithValidationInterfaceQueue();
+    CheckSupplyTotals(index);
+    BOOST_CHECK_EQUAL(GetFeesBurnedTotal(index), nFee);
+
+    // Disconnecting it drops it from the totals, and the block replacing it
+    // at the same height continues them from its parent
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, Params(), chainActive.Tip()));
+    }
+    SyncWithValidationInterfaceQueue();
+    CheckSupplyTotals(index);
+    BOOST_CHECK_EQUAL(GetFeesBurnedTotal(index), 0);
+
+    mempool.clear();
+    CreateAndProcessBlock({}, scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() != block.GetHash());
+    SyncWithValidationInterfaceQueue();
+    CheckSupplyTotals(index);
+    BOOST_CHECK_EQUAL(GetFeesBurnedTotal(index), 0);
+
+    UnregisterValidationInterface(&index);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
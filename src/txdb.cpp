@@ -22,6 +22,7 @@ static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
+static const char DB_STAKEINDEX = 'k';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
@@ -247,6 +248,24 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ReadStakeIndex(const COutPoint &outpoint, CStakePrevout &prevout) {
+    return Read(std::make_pair(DB_STAKEINDEX, outpoint), prevout);
+}
+
+bool CBlockTreeDB::WriteStakeIndex(const std::vector<std::pair<COutPoint, CStakePrevout> >&vect) {
+    CDBBatch batch(*this);
+    for (std::vector<std::pair<COutPoint,CStakePrevout> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
+        batch.Write(std::make_pair(DB_STAKEINDEX, it->first), it->second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseStakeIndex(const std::vector<COutPoint> &vect) {
+    CDBBatch batch(*this);
+    for (const COutPoint &outpoint : vect)
+        batch.Erase(std::make_pair(DB_STAKEINDEX, outpoint));
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
@@ -271,6 +290,8 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
     int nLastPercent = -1;
 
     int nMax = nHighest * 1.25;
+    int nPoWChecked = 0;
+    int nPoWTrusted = 0;
 
     // Load mapBlockIndex
     while (pcursor->Valid()) {
@@ -312,15 +333,26 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nMoneySupply   = diskindex.nMoneySupply;
                 pindexNew->nPOWBlockHeight   = diskindex.nPOWBlockHeight;
                 pindexNew->nFlags         = diskindex.nFlags;
+                pindexNew->SetBlockType();
                 pindexNew->prevoutStake   = diskindex.prevoutStake;
                 pindexNew->bnStakeModifier = diskindex.bnStakeModifier;
                 pindexNew->nStakeTime     = diskindex.nStakeTime;
                 pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
 
-                CBlockHeader tmp = pindexNew->GetBlockHeader();
-
-                if (pindexNew->IsProofOfWork() && !CheckProofOfWork(&tmp, consensusParams))
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                // Entries of blocks we stored and connected the transactions of passed
+                // CheckBlock(), and with it the proof of work, before they were written.
+                // -checkblockindexpow checks them again after startup. Headers-only entries
+                // may have been accepted without it, so those are checked here.
+                if (pindexNew->IsProofOfWork()) {
+                    if ((pindexNew->nStatus & BLOCK_HAVE_DATA) && pindexNew->IsValid(BLOCK_VALID_TRANSACTIONS)) {
+                        nPoWTrusted++;
+                    } else {
+                        CBlockHeader tmp = pindexNew->GetBlockHeader();
+                        if (!CheckProofOfWork(&tmp, consensusParams))
+                            return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                        nPoWChecked++;
+                    }
+                }
 
                 pcursor->Next();
             } else {
@@ -330,6 +362,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
             break;
         }
     }
+    LogPrintf("%s: checked proof of work of %d entries, trusted %d already valid entries\n", __func__, nPoWChecked, nPoWTrusted);
 
     return true;
 }
@@ -64,6 +64,37 @@ struct CDiskTxPos : public CDiskBlockPos
     }
 };
 
+/** What proof-of-stake validation needs to know about a transaction output, kept in the stake index */
+struct CStakePrevout
+{
+    CTxOut out;
+    unsigned int nTime; // of the transaction
+    int nHeight; // of the block including the transaction, to tell whether the entry holds for a branch
+    uint256 hashBlock; // of the block including the transaction, to tell whether the entry is stale
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        ::Serialize(s, CTxOutCompressor(REF(out)));
+        ::Serialize(s, VARINT(nTime));
+        ::Serialize(s, VARINT(nHeight));
+        ::Serialize(s, hashBlock);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        ::Unserialize(s, REF(CTxOutCompressor(out)));
+        ::Unserialize(s, VARINT(nTime));
+        ::Unserialize(s, VARINT(nHeight));
+        ::Unserialize(s, hashBlock);
+    }
+
+    CStakePrevout(const CTxOut &outIn, unsigned int nTimeIn, int nHeightIn, const uint256 &hashBlockIn) : out(outIn), nTime(nTimeIn), nHeight(nHeightIn), hashBlock(hashBlockIn) {
+    }
+
+    CStakePrevout() : nTime(0), nHeight(0) {
+    }
+};
+
 /** CCoinsView backed by the coin database (chainstate/) */
 class CCoinsViewDB final : public CCoinsView
 {
@@ -122,6 +153,9 @@ public:
     bool ReadReindexing(bool &fReindexing);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
+    bool ReadStakeIndex(const COutPoint &outpoint, CStakePrevout &prevout);
+    bool WriteStakeIndex(const std::vector<std::pair<COutPoint, CStakePrevout> > &vect);
+    bool EraseStakeIndex(const std::vector<COutPoint> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int& nHighest);
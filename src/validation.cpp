@@ -42,6 +42,7 @@
 #include <bignum.h>
 #include <checkpointsync.h>
 #include <keystore.h>
+#include <stakemodifiers.h>
 
 #include <future>
 #include <sstream>
@@ -227,6 +228,7 @@ int nScriptCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fTxIndex = false;
+bool fStakeIndex = DEFAULT_STAKEINDEX;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
@@ -1372,6 +1374,8 @@ void UpdateCoins(const CTransaction &tx, CCoinsViewCache &inputs, int nHeight) {
 }
 
 bool CScriptCheck::operator()() {
+    if (pblockSig)
+        return CheckBlockSignature(*pblockSig, cacheStore);
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
@@ -1522,7 +1526,9 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
 {
     CDiskBlockPos pos = pindex->GetUndoPos();
     if (pos.IsNull()) {
@@ -1553,6 +1559,8 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
+namespace {
+
 /** Abort with a message */
 bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
 {
@@ -1729,6 +1737,45 @@ static bool WriteTxIndexDataForBlock(const CBlock &block, CValidationState &stat
     return true;
 }
 
+// pulsar: index the outputs of the block for proof-of-stake validation
+static bool WriteStakeIndexDataForBlock(const CBlock &block, CValidationState &state, CBlockIndex *pindex) {
+    if (!fStakeIndex) return true;
+
+    std::vector <std::pair<COutPoint, CStakePrevout>> vPrevouts;
+    for (const CTransactionRef &tx : block.vtx) {
+        for (unsigned int i = 0; i < tx->vout.size(); i++) {
+            if (tx->vout[i].IsEmpty())
+                continue;
+            vPrevouts.push_back(std::make_pair(COutPoint(tx->GetHash(), i), CStakePrevout(tx->vout[i], tx->nTime, pindex->nHeight, pindex->GetBlockHash())));
+        }
+    }
+
+    if (!pblocktree->WriteStakeIndex(vPrevouts)) {
+        return AbortNode(state, "Failed to write stake index");
+    }
+
+    return true;
+}
+
+// pulsar: forget the outputs of a block leaving the active chain
+static bool EraseStakeIndexDataForBlock(const CBlock &block, CValidationState &state) {
+    if (!fStakeIndex) return true;
+
+    std::vector<COutPoint> vOutpoints;
+    for (const CTransactionRef &tx : block.vtx) {
+        for (unsigned int i = 0; i < tx->vout.size(); i++) {
+            if (!tx->vout[i].IsEmpty())
+                vOutpoints.push_back(COutPoint(tx->GetHash(), i));
+        }
+    }
+
+    if (!pblocktree->EraseStakeIndex(vOutpoints)) {
+        return AbortNode(state, "Failed to erase stake index");
+    }
+
+    return true;
+}
+
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
@@ -1736,6 +1783,122 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Closure representing the proof-of-work check of one header.
+ * The result is stored in *pfValid rather than returned, so that one header
+ * with bad proof of work does not stop the rest of the batch from being checked.
+ */
+class CPoWCheck
+{
+private:
+    const CBlockHeader *pheader;
+    const Consensus::Params *pparams;
+    bool *pfValid;
+
+public:
+    CPoWCheck(): pheader(nullptr), pparams(nullptr), pfValid(nullptr) {}
+    CPoWCheck(const CBlockHeader& headerIn, const Consensus::Params& paramsIn, bool* pfValidIn) :
+        pheader(&headerIn), pparams(&paramsIn), pfValid(pfValidIn) { }
+
+    bool operator()() {
+        *pfValid = CheckProofOfWork(pheader, *pparams);
+        return true;
+    }
+
+    void swap(CPoWCheck &check) {
+        std::swap(pheader, check.pheader);
+        std::swap(pparams, check.pparams);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+// A single header check is expensive, so hand them to the workers one by one
+static CCheckQueue<CPoWCheck> powcheckqueue(1);
+
+void ThreadPoWCheck() {
+    RenameThread("pulsar-powcheck");
+    powcheckqueue.Thread();
+}
+
+void CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers, const std::vector<bool>& vCheck, const Consensus::Params& params, std::vector<bool>& vValid)
+{
+    AssertLockNotHeld(cs_main);
+    assert(vCheck.size() == headers.size());
+    int64_t nTimeStart = GetTimeMicros();
+
+    // std::vector<bool> has no addressable elements, so collect the results here
+    std::unique_ptr<bool[]> pfValid(new bool[headers.size()]());
+    std::vector<CPoWCheck> vChecks;
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (vCheck[i])
+            vChecks.emplace_back(headers[i], params, &pfValid[i]);
+    }
+    const size_t nChecks = vChecks.size();
+    vValid.assign(headers.size(), false);
+    if (nChecks == 0)
+        return;
+
+    if (nScriptCheckThreads) {
+        CCheckQueueControl<CPoWCheck> control(&powcheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        for (CPoWCheck& check : vChecks)
+            check();
+    }
+
+    for (size_t i = 0; i < headers.size(); i++)
+        vValid[i] = pfValid[i];
+
+    int64_t nTime = GetTimeMicros() - nTimeStart;
+    LogPrint(BCLog::BENCH, "    - Check PoW of %u headers: %.2fms (%.2fms/header)\n", (unsigned int)nChecks, nTime * MILLI, nTime * MILLI / nChecks);
+}
+
+void ThreadCheckBlockIndexPoW(int nDepth)
+{
+    RenameThread("pulsar-checkpow");
+    const Consensus::Params& params = Params().GetConsensus();
+    int64_t nTimeStart = GetTimeMillis();
+
+    // Copy the headers so that cs_main is not held while hashing. Only the entries
+    // CBlockTreeDB::LoadBlockIndexGuts() trusted, the others were checked there.
+    auto fTrusted = [](const CBlockIndex* pindex) {
+        return pindex->IsProofOfWork() && (pindex->nStatus & BLOCK_HAVE_DATA) && pindex->IsValid(BLOCK_VALID_TRANSACTIONS);
+    };
+    std::vector<CBlockHeader> headers;
+    {
+        LOCK(cs_main);
+        if (nDepth < 0) {
+            for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
+                if (fTrusted(item.second))
+                    headers.push_back(item.second->GetBlockHeader());
+            }
+        } else {
+            for (const CBlockIndex* pindex = chainActive.Tip(); pindex && chainActive.Height() - pindex->nHeight < nDepth; pindex = pindex->pprev) {
+                if (fTrusted(pindex))
+                    headers.push_back(pindex->GetBlockHeader());
+            }
+        }
+    }
+    LogPrintf("%s: checking proof of work of %u block index entries\n", __func__, headers.size());
+
+    for (size_t nBegin = 0; nBegin < headers.size(); nBegin += CHECKBLOCKINDEXPOW_BATCH_SIZE) {
+        boost::this_thread::interruption_point();
+        size_t nEnd = std::min(headers.size(), nBegin + CHECKBLOCKINDEXPOW_BATCH_SIZE);
+        std::vector<CBlockHeader> batch(headers.begin() + nBegin, headers.begin() + nEnd);
+        std::vector<bool> vValid;
+        CheckHeadersProofOfWork(batch, std::vector<bool>(batch.size(), true), params, vValid);
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (!vValid[i]) {
+                AbortNode(strprintf("Block index entry %s has invalid proof of work", batch[i].GetHash().ToString()), _("Error loading block database"));
+                return;
+            }
+        }
+    }
+
+    LogPrintf("%s: proof of work of %u block index entries is valid (%dms)\n", __func__, headers.size(), GetTimeMillis() - nTimeStart);
+}
+
 static unsigned int GetBlockScriptFlags(const CBlockIndex *pindex, const Consensus::Params &consensusparams) {
     AssertLockHeld(cs_main);
 
@@ -1815,28 +1978,37 @@ static int64_t nTimeTotal = 0;
 static int64_t nBlocksTotal = 0;
 
 // These checks can only be done when all previous block have been added.
-bool PulsarContextualBlockChecks(const CBlock &block, CValidationState &state, CBlockIndex *pindex, bool fJustCheck) {
+// fCheckScript may be false only if ConnectBlock() verifies the coinstake kernel script afterwards.
+bool PulsarContextualBlockChecks(const CBlock &block, CValidationState &state, CBlockIndex *pindex, bool fJustCheck, bool fCheckScript = true) {
     uint256 hashProofOfStake = uint256();
     uint256 targetProofOfStake = uint256();
     // pulsar: verify hash target and signature of coinstake tx
-    if (block.IsProofOfStake() && !CheckProofOfStake(state, pindex->pprev, block.vtx[1], block.nBits, hashProofOfStake, targetProofOfStake)) {
+    if (block.IsProofOfStake() && !CheckProofOfStake(state, pindex->pprev, block.vtx[1], block.nBits, hashProofOfStake, targetProofOfStake, fCheckScript)) {
         LogPrintf("WARNING: %s: check proof-of-stake failed for block %s\n", __func__, block.GetHash().ToString());
         return false; // do not error here as we expect this during initial block download
     }
 
     // set necessary pindex fields
-    pindex->bnStakeModifier = ComputeStakeModifier(pindex->pprev, block.IsProofOfWork() ? block.GetHash() : block.vtx[1]->vin[0].prevout.hash);
+    const uint256 bnStakeModifier = ComputeStakeModifier(pindex->pprev, block.IsProofOfWork() ? block.GetHash() : block.vtx[1]->vin[0].prevout.hash);
+    bool fChanged = pindex->bnStakeModifier != bnStakeModifier;
+    pindex->bnStakeModifier = bnStakeModifier;
     if (fJustCheck)
         return true;
 
     // write everything to index
     if (block.IsProofOfStake())
     {
+        fChanged |= pindex->prevoutStake != block.vtx[1]->vin[0].prevout ||
+                    pindex->nStakeTime != block.vtx[1]->nTime ||
+                    pindex->hashProofOfStake != hashProofOfStake;
         pindex->prevoutStake = block.vtx[1]->vin[0].prevout;
         pindex->nStakeTime = block.vtx[1]->nTime;
         pindex->hashProofOfStake = hashProofOfStake;
     }
-    setDirtyBlockIndex.insert(pindex);  // queue a write to disk
+    // Blocks connected again, e.g. with -reindex-chainstate, already have
+    // these fields on disk
+    if (fChanged)
+        setDirtyBlockIndex.insert(pindex);  // queue a write to disk
 
     return true;
 }
@@ -1855,7 +2027,10 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     const Consensus::Params& params = Params().GetConsensus();
     int64_t nTimeStart = GetTimeMicros();
-    if (!PulsarContextualBlockChecks(block, state, pindex, fJustCheck))
+    // pulsar: the coinstake kernel script is verified below, on the script-check
+    // threads, even if the other scripts of the block are skipped. A block
+    // checked in AcceptBlock() finds it in the signature cache.
+    if (!PulsarContextualBlockChecks(block, state, pindex, fJustCheck, false))
         return error("%s: failed PoS check %s", __func__, FormatStateMessage(state));
 
   //  if (block.IsProofOfWork() && (pindex->nHeight > 0 && pindex->pprev->nPOWBlockHeight + 1 > params.nTotalPOWBlock))
@@ -1875,7 +2050,11 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // GetAdjustedTime() to go backward).
-    if (!CheckBlock(block, state, chainparams.GetConsensus(), !fJustCheck, !fJustCheck))
+    // pulsar: the block signature of a proof-of-stake block is checked below on
+    // the script-check threads. Only a signature cache hit, left by the check
+    // before the block was stored, saves verifying it again.
+    const bool fCheckBlockSig = !fJustCheck && block.IsProofOfStake();
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), !fJustCheck, !fJustCheck, false))
         return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
 
     // verify that the view's current state corresponds to the previous block
@@ -1970,7 +2149,19 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     CBlockUndo blockundo;
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    // pulsar: the queue is used without script checks too, for the block
+    // signature and the coinstake kernel script
+    CCheckQueueControl<CScriptCheck> control(nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+
+    if (fCheckBlockSig) {
+        if (nScriptCheckThreads) {
+            std::vector<CScriptCheck> vChecks;
+            vChecks.emplace_back(block, false);
+            control.Add(vChecks);
+        } else if (!CheckBlockSignature(block)) {
+            return state.DoS(100, error("%s: bad block signature", __func__), REJECT_INVALID, "bad-blk-sign");
+        }
+    }
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2035,6 +2226,18 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHash().ToString(), FormatStateMessage(state));
+            // pulsar: the kernel is part of the proof of stake, it is verified
+            // even when script checks are skipped
+            if (!fScriptChecks && tx.IsCoinStake()) {
+                CScriptCheck check(view.AccessCoin(tx.vin[0].prevout).out, tx, 0, SCRIPT_VERIFY_P2SH, fCacheResults, &txdata[i]);
+                if (nScriptCheckThreads) {
+                    vChecks.push_back(CScriptCheck());
+                    check.swap(vChecks.back());
+                } else if (!check()) {
+                    return state.DoS(100, error("%s: VerifyScript failed on coinstake %s", __func__, tx.GetHash().ToString()),
+                                     REJECT_INVALID, "invalid-pos-script");
+                }
+            }
             control.Add(vChecks);
         }
 
@@ -2049,8 +2252,15 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     // pulsar: coinbase reward check relocated to CheckBlock()
 
-    if (!control.Wait())
+    if (!control.Wait()) {
+        // pulsar: tell which check failed where the reject reason matters
+        if (fCheckBlockSig && !CheckBlockSignature(block))
+            return state.DoS(100, error("%s: bad block signature", __func__), REJECT_INVALID, "bad-blk-sign");
+        if (!fScriptChecks && block.IsProofOfStake())
+            return state.DoS(100, error("%s: VerifyScript failed on coinstake %s", __func__, block.vtx[1]->GetHash().ToString()),
+                             REJECT_INVALID, "invalid-pos-script");
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+    }
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
 
@@ -2078,6 +2288,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     if (!WriteTxIndexDataForBlock(block, state, pindex))
         return false;
 
+    if (!WriteStakeIndexDataForBlock(block, state, pindex))
+        return false;
+
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2157,6 +2370,9 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
                     return AbortNode(state, "Failed to write to block index database");
                 }
             }
+            // pulsar: the stake modifier table can be rebuilt from the block index, so failing to write it is not fatal
+            if (pstakemodifiers && !pstakemodifiers->Flush())
+                LogPrintf("%s: failed to write stake modifier table\n", __func__);
             nLastWrite = nNow;
         }
         // Flush best chain related state. This can only be done if the blocks / block index write was also done.
@@ -2300,6 +2516,9 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
         bool flushed = view.Flush();
         assert(flushed);
     }
+    // Not in DisconnectBlock(), which also runs on throwaway views in VerifyDB()
+    if (!EraseStakeIndexDataForBlock(block, state))
+        return false;
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * MILLI);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(chainparams, state, FLUSH_STATE_IF_NEEDED))
@@ -2319,6 +2538,8 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
     }
 
     chainActive.SetTip(pindexDelete->pprev);
+    if (pstakemodifiers)
+        pstakemodifiers->Disconnect(pindexDelete);
 
     UpdateTip(pindexDelete->pprev, chainparams);
     // Let wallets know transactions went from 1-confirmed to
@@ -2453,6 +2674,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     disconnectpool.removeForBlock(blockConnecting.vtx);
     // Update chainActive & related variables.
     chainActive.SetTip(pindexNew);
+    if (pstakemodifiers)
+        pstakemodifiers->Connect(pindexNew);
     UpdateTip(pindexNew, chainparams);
 
     int64_t nTime6 = GetTimeMicros();
@@ -2891,6 +3114,7 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block, bool fSetAs
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     if (fSetAsProofOfstake)
         pindexNew->SetProofOfStake();
+    pindexNew->BuildPrevSameType();
     pindexNew->nChainTrust = (pindexNew->pprev ? pindexNew->pprev->nChainTrust : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
     if (pindexBestHeader == nullptr || pindexBestHeader->nChainTrust < pindexNew->nChainTrust)
@@ -2914,6 +3138,7 @@ bool CChainState::ReceivedBlockTransactions(const CBlock &block, CValidationStat
     }
     pindexNew->RaiseValidity(BLOCK_VALID_TRANSACTIONS);
     setDirtyBlockIndex.insert(pindexNew);
+    GetMainSignals().BlockTransactionsReceived(pindexNew);
 
     if (pindexNew->pprev == nullptr || pindexNew->pprev->nChainTx) {
         // If pindexNew is the genesis block or all parents are BLOCK_VALID_TRANSACTIONS.
@@ -3122,14 +3347,17 @@ bool CheckBlock(const CBlock &block, CValidationState &state, const Consensus::P
     if (nSigOps * WITNESS_SCALE_FACTOR > MAX_BLOCK_SIGOPS_COST)
         return state.DoS(100, false, REJECT_INVALID, "bad-blk-sigops", false, "out-of-bounds SigOpCount");
 
-    if (fCheckPOW && fCheckMerkleRoot)
-        block.fChecked = true;
-
     // pulsar: check block signature
     // Only check block signature if check merkle root, c.f. commit 3cd01fdf
     // rfc6: validate signatures of proof of stake blocks only after 0.8 fork
-    if (fCheckMerkleRoot && fCheckSignature && block.IsProofOfStake() && !CheckBlockSignature(block))
-        return state.DoS(100, false, REJECT_INVALID, "bad-blk-sign", false, strprintf("%s : bad block signature", __func__));
+    // The result is cached so that ConnectBlock() does not verify it again.
+    // The block hash does not commit to the signature, so a bad one may have
+    // been put on a valid block by a peer: the failure allows corruption.
+    if (fCheckMerkleRoot && fCheckSignature && block.IsProofOfStake() && !CheckBlockSignature(block, true))
+        return state.DoS(100, false, REJECT_INVALID, "bad-blk-sign", true, strprintf("%s : bad block signature", __func__));
+
+    if (fCheckPOW && fCheckMerkleRoot && fCheckSignature)
+        block.fChecked = true;
 
     return true;
 }
@@ -3579,7 +3807,11 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
     }
     if (fNewBlock) *fNewBlock = true;
 
-    if (!CheckBlock(block, state, chainparams.GetConsensus()) ||
+    // pulsar: the block signature and the coinstake kernel script are verified
+    // before the block is stored, and left in the signature cache for
+    // ConnectBlock(). Blocks loaded from disk without PoS checks have them
+    // verified in ConnectBlock(), on the script-check threads.
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), true, true, fCheckPoS) ||
         !ContextualCheckBlock(block, state, pindex->pprev)) {
         if (state.IsInvalid() && !state.CorruptionPossible()) {
             pindex->nStatus |= BLOCK_FAILED_VALID;
@@ -3830,8 +4062,10 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
             setBlockIndexCandidates.insert(pindex);
         if (pindex->nStatus & BLOCK_FAILED_MASK && (!pindexBestInvalid || pindex->nChainTrust > pindexBestInvalid->nChainTrust))
             pindexBestInvalid = pindex;
-        if (pindex->pprev)
+        if (pindex->pprev) {
             pindex->BuildSkip();
+            pindex->BuildPrevSameType();
+        }
         if (pindex->IsValid(BLOCK_VALID_TREE) && (pindexBestHeader == nullptr || CBlockIndexWorkComparator()(pindexBestHeader, pindex)))
             pindexBestHeader = pindex;
     }
@@ -3976,6 +4210,16 @@ bool CVerifyDB::VerifyDB(const CChainParams &chainparams, CCoinsView *coinsview,
         if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams.GetConsensus()))
             return error("%s: *** found bad block at %d, hash=%s (%s)\n", __func__,
                          pindex->nHeight, pindex->GetBlockHash().ToString(), FormatStateMessage(state));
+        // pulsar: check level 1: verify the stake modifier and its entry in the stake modifier table
+        if (nCheckLevel >= 1) {
+            const uint256 kernel = block.IsProofOfWork() ? block.GetHash() : block.vtx[1]->vin[0].prevout.hash;
+            CStakeModifierRecord record;
+            if (pindex->bnStakeModifier != ComputeStakeModifier(pindex->pprev, kernel))
+                return error("VerifyDB(): *** found bad stake modifier at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+            if (pstakemodifiers && pstakemodifiers->Lookup(pindex->nHeight, record) &&
+                (record.hashBlock != pindex->GetBlockHash() || record.hashKernel != kernel || record.bnStakeModifier != pindex->bnStakeModifier))
+                return error("VerifyDB(): *** found bad stake modifier table entry at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+        }
         // check level 2: verify undo validity
         if (nCheckLevel >= 2 && pindex) {
             CBlockUndo undo;
@@ -4816,18 +5060,26 @@ public:
 
 
 bool IsConfirmedInNPrevBlocks(const uint256 &hashBlock, const CBlockIndex *pindexFrom, int nMaxDepth, int &nActualDepth) {
-    for (const CBlockIndex *pindex = pindexFrom; pindex && pindexFrom->nHeight - pindex->nHeight < nMaxDepth; pindex = pindex->pprev) {
-        if (hashBlock == pindex->GetBlockHash()) {
-            nActualDepth = pindexFrom->nHeight - pindex->nHeight;
-            return true;
-        }
-    }
-    return false;
+    AssertLockHeld(cs_main);
+    if (!pindexFrom)
+        return false;
+
+    // The block's height tells where it would be among the ancestors of pindexFrom
+    BlockMap::const_iterator mi = mapBlockIndex.find(hashBlock);
+    if (mi == mapBlockIndex.end())
+        return false;
+    const CBlockIndex *pindex = mi->second;
+    int nDepth = pindexFrom->nHeight - pindex->nHeight;
+    if (nDepth < 0 || nDepth >= nMaxDepth || pindexFrom->GetAncestor(pindex->nHeight) != pindex)
+        return false;
+
+    nActualDepth = nDepth;
+    return true;
 }
 
- bool CheckAge(const CBlockIndex *pindexTip, const uint256 &hashKernelBlock, int &nDepth) {
+ bool CheckAge(const CBlockIndex *pindexTip, int nHeightKernel, int &nDepth) {
     // pindexTip is the current tip of the chain
-    // hashKernelBlock is the hash of the block containing the kernel transaction
+    // nHeightKernel is the height of the block containing the kernel transaction
      int nRequiredDepth;
      if (IsReductionActive(chainActive.Tip(), Params().GetConsensus()))
      {
@@ -4836,7 +5088,11 @@ bool IsConfirmedInNPrevBlocks(const uint256 &hashBlock, const CBlockIndex *pinde
          nRequiredDepth = std::min((int)(Params().GetConsensus().nStakeMinConfirmations), (int)(pindexTip->nHeight / 2));
      }
 
-    if (IsConfirmedInNPrevBlocks(hashKernelBlock, pindexTip, nRequiredDepth, nDepth)) {
+    // Coins in the view are on the chain of pindexTip, so the height gives the depth directly.
+    // A coin above pindexTip is not confirmed by it at all.
+    int nActualDepth = pindexTip->nHeight - nHeightKernel;
+    if (nActualDepth < nRequiredDepth) {
+        nDepth = nActualDepth;
         return false;
     }
     return true;
@@ -4857,7 +5113,7 @@ bool GetCoinAge(const CTransaction &tx, const CCoinsViewCache &view, const CBloc
         return true;
 
     for (const auto &txin : tx.vin) {
-        // First try finding the previous transaction in database
+        // Find the previous output in the coins view
         const COutPoint &prevout = txin.prevout;
         Coin coin;
 
@@ -4866,38 +5122,20 @@ bool GetCoinAge(const CTransaction &tx, const CCoinsViewCache &view, const CBloc
         if (tx.nTime < coin.nTime)
             return false;  // Transaction timestamp violation
 
-        // Transaction index is required to get to block header
-        if (!fTxIndex)
-            return false;  // Transaction index not available
-
-        CDiskTxPos postx;
-        CTransactionRef txPrev;
-        if (pblocktree->ReadTxIndex(prevout.hash, postx)) {
-            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-            CBlockHeader header;
-            try {
-                file >> header;
-                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                file >> txPrev;
-            } catch (std::exception &e) {
-                return error("%s() : deserialize or I/O error in GetCoinAge()", __PRETTY_FUNCTION__);
-            }
-            if (txPrev->GetHash() != prevout.hash)
-                return error("%s() : txid mismatch in GetCoinAge()", __PRETTY_FUNCTION__);
-            if (nDepth < 0) {
-                if (!CheckAge(pindexPrev, header.GetHash(), nDepth)) {
-                    LogPrintf("coinage: coin age skip nDepth=%d\n", nDepth + 1);
-                    continue; // only count coins meeting min confirmations requirement
-                }
+        // The coin carries the value, time and height of the previous transaction,
+        // so neither the transaction index nor the block files are needed
+        if (nDepth < 0) {
+            if (!CheckAge(pindexPrev, coin.nHeight, nDepth)) {
+                LogPrintf("coinage: coin age skip nDepth=%d\n", nDepth + 1);
+                continue; // only count coins meeting min confirmations requirement
             }
+        }
 
-            int64_t nValueIn = txPrev->vout[txin.prevout.n].nValue;
-            bnCentSecond += arith_uint256(nValueIn) * (tx.nTime - txPrev->nTime) / CENT;
+        int64_t nValueIn = coin.out.nValue;
+        bnCentSecond += arith_uint256(nValueIn) * (tx.nTime - coin.nTime) / CENT;
 
-            if (gArgs.GetBoolArg("-printcoinage", false))
-                LogPrintf("coin age nValueIn=%-12lld nTimeDiff=%d bnCentSecond=%s\n", nValueIn, tx.nTime - txPrev->nTime, bnCentSecond.ToString());
-        } else
-            return error("%s() : tx missing in tx index in GetCoinAge()", __PRETTY_FUNCTION__);
+        if (gArgs.GetBoolArg("-printcoinage", false))
+            LogPrintf("coin age nValueIn=%-12lld nTimeDiff=%d bnCentSecond=%s\n", nValueIn, tx.nTime - coin.nTime, bnCentSecond.ToString());
     }
 
     arith_uint256 bnCoinDay = bnCentSecond * CENT / COIN / (24 * 60 * 60);
@@ -4932,7 +5170,7 @@ bool SignBlock(CBlock& block, const CKeyStore& keystore)
 }
 
 // pulsar: check block signature
-bool CheckBlockSignature(const CBlock& block)
+bool CheckBlockSignature(const CBlock& block, bool fCacheStore)
 {
     if (block.GetHash() == Params().GetConsensus().hashGenesisBlock)
         return block.vchBlockSig.empty();
@@ -4949,7 +5187,7 @@ bool CheckBlockSignature(const CBlock& block)
         CPubKey key(vchPubKey);
         if (block.vchBlockSig.empty())
             return false;
-        return key.Verify(block.GetHash(), block.vchBlockSig);
+        return CachingVerifySignature(block.vchBlockSig, key, block.GetHash(), fCacheStore);
     }
     return false;
 }
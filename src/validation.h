@@ -32,6 +32,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CChainParams;
 class CCoinsViewDB;
 class CInv;
@@ -74,6 +75,10 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Default for -checkblockindexpow, 0 = do not check the trusted proof of work of loaded block index entries again */
+static const int DEFAULT_CHECKBLOCKINDEXPOW = 0;
+/** Number of block index entries -checkblockindexpow hands to the PoW checking threads at once */
+static const unsigned int CHECKBLOCKINDEXPOW_BATCH_SIZE = 500;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -133,6 +138,7 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = true;  // pulsar: txindex is required for PoS calculations (might change in the future)
+static const bool DEFAULT_STAKEINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -170,6 +176,7 @@ extern std::atomic_bool fImporting;
 extern std::atomic_bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fStakeIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern bool fCheckBlockIndex;
@@ -263,6 +270,21 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the proof-of-work checking thread */
+void ThreadPoWCheck();
+/**
+ * Check again the proof of work of the block index entries that were trusted when
+ * loaded at startup: those of the nDepth last blocks of the active chain, or all
+ * of them if nDepth is negative. Aborts the node if one of them is invalid.
+ */
+void ThreadCheckBlockIndexPoW(int nDepth);
+/**
+ * Check the proof of work of the headers selected by vCheck, in parallel on the
+ * PoW checking threads when there are any. Valid headers end up in the proof-of-work
+ * cache, so CheckBlockHeader does not hash them again. On return vValid[i] tells
+ * whether headers[i] was checked and found valid. Must be called without cs_main held.
+ */
+void CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers, const std::vector<bool>& vCheck, const Consensus::Params& params, std::vector<bool>& vValid);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 
@@ -354,11 +376,15 @@ private:
     bool cacheStore;
     ScriptError error;
     PrecomputedTransactionData *txdata;
+    const CBlock *pblockSig; // pulsar: set if this checks the signature of a proof-of-stake block
 
 public:
-    CScriptCheck(): ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
+    CScriptCheck(): ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR), pblockSig(nullptr) {}
     CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
-        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
+        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn), pblockSig(nullptr) { }
+    // pulsar: check the block signature of a proof-of-stake block on the script-check threads
+    CScriptCheck(const CBlock& blockIn, bool cacheIn) :
+        ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(nullptr), pblockSig(&blockIn) { }
 
     bool operator()();
 
@@ -370,6 +396,7 @@ public:
         std::swap(cacheStore, check.cacheStore);
         std::swap(error, check.error);
         std::swap(txdata, check.txdata);
+        std::swap(pblockSig, check.pblockSig);
     }
 
     ScriptError GetScriptError() const { return error; }
@@ -382,6 +409,7 @@ void InitScriptExecutionCache();
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -474,10 +502,10 @@ CAmount GetProofOfStakeReward(CAmount nCoinAge);
 CAmount GetBlockReward(unsigned int nHeight);
 
 bool IsConfirmedInNPrevBlocks(const uint256 &hashBlock, const CBlockIndex *pindexFrom, int nMaxDepth, int &nActualDepth);
-bool CheckAge(const CBlockIndex *pindexTip, const uint256 &hashKernelBlock, int &nDepth);
+bool CheckAge(const CBlockIndex *pindexTip, int nHeightKernel, int &nDepth);
 bool GetCoinAge(const CTransaction& tx, const CCoinsViewCache &view, const CBlockIndex* pindexPrev, uint64_t& nCoinAge, int nDepth = -1); // pulsar: get transaction coin age
 bool SignBlock(CBlock& block, const CKeyStore& keystore);
-bool CheckBlockSignature(const CBlock& block);
+bool CheckBlockSignature(const CBlock& block, bool fCacheStore = false);
 /** Return the median number of blocks that other nodes claim to have */
 int GetNumBlocksOfPeers();
 /** Return the median number of connected nodes */
@@ -10,6 +10,7 @@
 #include <utility>
 #include <vector>
 
+#include <chainparams.h>
 #include <consensus/validation.h>
 #include <rpc/server.h>
 #include <test/test_bitcoin.h>
@@ -700,4 +701,100 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2);
 }
 
+/** ListCoinsTestingSetup with the wallet following the chain, as the stake candidates do */
+class StakeCandidatesTestingSetup : public ListCoinsTestingSetup
+{
+public:
+    StakeCandidatesTestingSetup()
+    {
+        RegisterValidationInterface(wallet.get());
+    }
+
+    ~StakeCandidatesTestingSetup()
+    {
+        UnregisterValidationInterface(wallet.get());
+    }
+
+    // Compare the incrementally kept stake candidates with a full recompute from mapWallet
+    void CheckStakeCandidates()
+    {
+        SyncWithValidationInterfaceQueue();
+        LOCK2(cs_main, wallet->cs_wallet);
+        size_t nCandidates = 0;
+        CAmount nValue = 0;
+        std::map<int, CAmount> mapValueByHeight[2];
+        for (const auto& entry : wallet->mapWallet) {
+            const CWalletTx& wtx = entry.second;
+            BlockMap::const_iterator mi = mapBlockIndex.find(wtx.hashBlock);
+            if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+                continue;
+            for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
+                const CTxOut& txout = wtx.tx->vout[i];
+                if ((wallet->IsMine(txout) & ISMINE_SPENDABLE) == ISMINE_NO || wallet->IsSpent(wtx.GetHash(), i))
+                    continue;
+                nCandidates++;
+                nValue += txout.nValue;
+                mapValueByHeight[wtx.IsCoinBase() || wtx.IsCoinStake()][mi->second->nHeight] += txout.nValue;
+            }
+        }
+        BOOST_CHECK_EQUAL(wallet->GetStakeCandidates().size(), nCandidates);
+        BOOST_CHECK_EQUAL(wallet->GetStakeCandidatesValue(), nValue);
+        BOOST_CHECK(wallet->GetStakeValueByHeight(false) == mapValueByHeight[0]);
+        BOOST_CHECK(wallet->GetStakeValueByHeight(true) == mapValueByHeight[1]);
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(stake_candidates_incremental, StakeCandidatesTestingSetup)
+{
+    CheckStakeCandidates();
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK(!wallet->GetStakeCandidates().empty());
+    }
+
+    // New coinbase outputs
+    CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    CheckStakeCandidates();
+
+    // A spend, erasing its input and adding its change once confirmed
+    AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+    CheckStakeCandidates();
+
+    // Reorg of the block with the spend, then back to it
+    CBlockIndex* pindexSpend = chainActive.Tip();
+    {
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, Params(), pindexSpend));
+        BOOST_CHECK(ActivateBestChain(state, Params()));
+    }
+    BOOST_CHECK(chainActive.Tip() == pindexSpend->pprev);
+    CheckStakeCandidates();
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(ResetBlockFailureFlags(pindexSpend));
+    }
+    {
+        CValidationState state;
+        BOOST_CHECK(ActivateBestChain(state, Params()));
+    }
+    BOOST_CHECK(chainActive.Tip() == pindexSpend);
+    CheckStakeCandidates();
+
+    // Reload, which rebuilds the candidates from mapWallet
+    std::map<COutPoint, CStakeCandidate>::size_type nCandidates;
+    CAmount nValue;
+    {
+        LOCK(wallet->cs_wallet);
+        nCandidates = wallet->GetStakeCandidates().size();
+        nValue = wallet->GetStakeCandidatesValue();
+    }
+    wallet->LoadStakeCandidates();
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK_EQUAL(wallet->GetStakeCandidates().size(), nCandidates);
+        BOOST_CHECK_EQUAL(wallet->GetStakeCandidatesValue(), nValue);
+    }
+    CheckStakeCandidates();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -907,6 +907,12 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         AddToSpends(hash);
     }
 
+    // Outputs spent by a transaction cannot stake
+    if (!wtx.IsCoinBase()) {
+        for (const CTxIn& txin : wtx.tx->vin)
+            EraseStakeCandidate(txin.prevout);
+    }
+
     bool fUpdated = false;
     if (!fInsertedNew)
     {
@@ -1061,7 +1067,11 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const CBlockI
             if (pIndex != nullptr)
                 wtx.SetMerkleBranch(pIndex, posInBlock);
 
-            return AddToWallet(wtx, false);
+            if (!AddToWallet(wtx, false))
+                return false;
+            if (pIndex != nullptr)
+                AddStakeCandidates(tx, pIndex);
+            return true;
         }
     }
     return false;
@@ -1128,6 +1138,7 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
                 if (it != mapWallet.end()) {
                     it->second.MarkDirty();
                 }
+                RestoreStakeCandidate(txin.prevout);
             }
         }
     }
@@ -1191,6 +1202,7 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
                 if (it != mapWallet.end()) {
                     it->second.MarkDirty();
                 }
+                RestoreStakeCandidate(txin.prevout);
             }
         }
     }
@@ -1213,6 +1225,124 @@ void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pin
     }
 }
 
+CStakeCandidate::CStakeCandidate(CAmount nValueIn, unsigned int nTimeTxIn, const CBlockIndex* pindex, bool fGeneratedIn) :
+    nValue(nValueIn), nTimeTx(nTimeTxIn), hashBlock(pindex->GetBlockHash()), nHeight(pindex->nHeight), nTimeBlock(pindex->nTime), fGenerated(fGeneratedIn)
+{
+}
+
+// Depths at which ordinary and coinbase/coinstake outputs can stake
+static void GetStakeMinDepths(int& nMinDepth, int& nMinDepthGenerated)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    if (IsReductionActive(chainActive.Tip(), params)) {
+        nMinDepth = params.nStakeMinConfirmations_Reduction;
+        nMinDepthGenerated = std::max(nMinDepth, params.nCoinbaseMaturity_Reduction + 1);
+    } else {
+        nMinDepth = params.nStakeMinConfirmations;
+        nMinDepthGenerated = std::max(nMinDepth, params.nCoinbaseMaturity + 1);
+    }
+}
+
+void CWallet::AddStakeCandidate(const COutPoint& outpoint, const CStakeCandidate& candidate) {
+    AssertLockHeld(cs_wallet);
+    EraseStakeCandidate(outpoint);
+    mapStakeCandidates.emplace(outpoint, candidate);
+    nStakeCandidatesValue += candidate.nValue;
+    mapStakeValueByHeight[candidate.fGenerated][candidate.nHeight] += candidate.nValue;
+}
+
+void CWallet::EraseStakeCandidate(const COutPoint& outpoint) {
+    AssertLockHeld(cs_wallet);
+    auto it = mapStakeCandidates.find(outpoint);
+    if (it == mapStakeCandidates.end())
+        return;
+    const CStakeCandidate& candidate = it->second;
+    nStakeCandidatesValue -= candidate.nValue;
+    auto itHeight = mapStakeValueByHeight[candidate.fGenerated].find(candidate.nHeight);
+    if ((itHeight->second -= candidate.nValue) == 0)
+        mapStakeValueByHeight[candidate.fGenerated].erase(itHeight);
+    mapStakeCandidates.erase(it);
+}
+
+void CWallet::AddStakeCandidates(const CTransaction& tx, const CBlockIndex* pindex) {
+    AssertLockHeld(cs_wallet);
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        if ((IsMine(tx.vout[i]) & ISMINE_SPENDABLE) != ISMINE_NO && !IsSpent(tx.GetHash(), i))
+            AddStakeCandidate(COutPoint(tx.GetHash(), i), CStakeCandidate(tx.vout[i].nValue, tx.nTime, pindex, tx.IsCoinBase() || tx.IsCoinStake()));
+    }
+}
+
+void CWallet::RestoreStakeCandidate(const COutPoint& outpoint) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+    auto it = mapWallet.find(outpoint.hash);
+    if (it == mapWallet.end() || outpoint.n >= it->second.tx->vout.size() || IsSpent(outpoint.hash, outpoint.n))
+        return;
+    const CWalletTx& wtx = it->second;
+    BlockMap::const_iterator mi = mapBlockIndex.find(wtx.hashBlock);
+    if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+        return;
+    const CTxOut& txout = wtx.tx->vout[outpoint.n];
+    if ((IsMine(txout) & ISMINE_SPENDABLE) != ISMINE_NO)
+        AddStakeCandidate(outpoint, CStakeCandidate(txout.nValue, wtx.tx->nTime, mi->second, wtx.IsCoinBase() || wtx.IsCoinStake()));
+}
+
+void CWallet::LoadStakeCandidates() {
+    LOCK2(cs_main, cs_wallet);
+    mapStakeCandidates.clear();
+    nStakeCandidatesValue = 0;
+    mapStakeValueByHeight[0].clear();
+    mapStakeValueByHeight[1].clear();
+    for (const auto& entry : mapWallet) {
+        const CWalletTx& wtx = entry.second;
+        BlockMap::const_iterator mi = mapBlockIndex.find(wtx.hashBlock);
+        if (mi != mapBlockIndex.end() && chainActive.Contains(mi->second))
+            AddStakeCandidates(*wtx.tx, mi->second);
+    }
+    LogPrintf("Stake candidates: %u outputs worth %s\n", mapStakeCandidates.size(), FormatMoney(nStakeCandidatesValue));
+}
+
+CAmount CWallet::GetStakeableValue() const {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+    int nMinDepth, nMinDepthGenerated;
+    GetStakeMinDepths(nMinDepth, nMinDepthGenerated);
+    // Outputs confirmed above these heights are not deep enough yet
+    const int nMaxHeight[2] = {chainActive.Height() + 1 - nMinDepth, chainActive.Height() + 1 - nMinDepthGenerated};
+
+    CAmount nValue = nStakeCandidatesValue;
+    for (int i = 0; i < 2; i++) {
+        for (auto it = mapStakeValueByHeight[i].upper_bound(nMaxHeight[i]); it != mapStakeValueByHeight[i].end(); ++it)
+            nValue -= it->second;
+    }
+    for (const COutPoint& outpoint : setLockedCoins) {
+        auto it = mapStakeCandidates.find(outpoint);
+        if (it != mapStakeCandidates.end() && it->second.nHeight <= nMaxHeight[it->second.fGenerated])
+            nValue -= it->second.nValue;
+    }
+    return nValue;
+}
+
+bool CWallet::GetStakeCandidate(const CWalletTx& wtx, unsigned int n, CStakeCandidate& candidate) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+    auto it = mapStakeCandidates.find(COutPoint(wtx.GetHash(), n));
+    if (it != mapStakeCandidates.end()) {
+        candidate = it->second;
+        return true;
+    }
+
+    BlockMap::const_iterator mi = mapBlockIndex.find(wtx.hashBlock);
+    if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+        return false;
+    AddStakeCandidates(*wtx.tx, mi->second);
+    it = mapStakeCandidates.find(COutPoint(wtx.GetHash(), n));
+    if (it == mapStakeCandidates.end())
+        return false;
+    candidate = it->second;
+    return true;
+}
+
 void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx) {
     LOCK2(cs_main, cs_wallet);
     SyncTransaction(ptx);
@@ -1258,6 +1388,13 @@ void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
 
     for (const CTransactionRef& ptx : pblock->vtx) {
         SyncTransaction(ptx);
+
+        for (unsigned int i = 0; i < ptx->vout.size(); i++)
+            EraseStakeCandidate(COutPoint(ptx->GetHash(), i));
+        if (!ptx->IsCoinBase()) {
+            for (const CTxIn& txin : ptx->vin)
+                RestoreStakeCandidate(txin.prevout);
+        }
     }
 }
 
@@ -2318,46 +2455,35 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
 void CWallet::AvailableCoinsForStaking(std::vector<COutput> &vCoins, uint32_t nSpendTime) const
 {
     vCoins.clear();
-    const Consensus::Params& params = Params().GetConsensus();
 
     {
         LOCK2(cs_main, cs_wallet);
 
-        for (const auto& entry : mapWallet)
+        int nMinDepth, nMinDepthGenerated;
+        GetStakeMinDepths(nMinDepth, nMinDepthGenerated);
+
+        // Only our confirmed, unspent and spendable outputs are stake candidates
+        for (const auto& entry : mapStakeCandidates)
         {
-            const uint256& wtxid = entry.first;
-            const CWalletTx* pcoin = &entry.second;
-            int nDepth = pcoin->GetDepthInMainChain();
-            bool safeTx = pcoin->IsTrusted();
-            if (!CheckFinalTx(*pcoin->tx))
-                continue;
-            if (nSpendTime > 0 && pcoin->tx->nTime > nSpendTime)
+            const COutPoint& outpoint = entry.first;
+            const CStakeCandidate& candidate = entry.second;
+            if (nSpendTime > 0 && candidate.nTimeTx > nSpendTime)
                 continue;  // pulsar: timestamp must not exceed spend time
-            if ((pcoin->IsCoinBase() || pcoin->IsCoinStake()) && pcoin->GetBlocksToMaturity() > 0)
+            int nDepth = chainActive.Height() - candidate.nHeight + 1;
+            if (nDepth < (candidate.fGenerated ? nMinDepthGenerated : nMinDepth))
                 continue;
-            if (IsReductionActive(chainActive.Tip(), Params().GetConsensus()))
-            {
-                if (nDepth < params.nStakeMinConfirmations_Reduction)
-                    continue;
-            }
-            else if (nDepth < params.nStakeMinConfirmations)
+            if (IsLockedCoin(outpoint.hash, outpoint.n))
+                continue;
+            if (IsSpent(outpoint.hash, outpoint.n))
                 continue;
-            for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
-                if (IsLockedCoin(entry.first, i))
-                    continue;
-                if (IsSpent(wtxid, i))
-                    continue;
-
-                isminetype mine = IsMine(pcoin->tx->vout[i]);
-                if (mine == ISMINE_NO) {
-                    continue;
-                }
-
-                bool fSpendableIn = ((mine & ISMINE_SPENDABLE) != ISMINE_NO);
-                bool fSolvableIn = (mine & (ISMINE_SPENDABLE | ISMINE_WATCH_SOLVABLE)) != ISMINE_NO;
 
-                vCoins.push_back(COutput(pcoin, i, nDepth, fSpendableIn, fSolvableIn, safeTx));
-            }
+            auto it = mapWallet.find(outpoint.hash);
+            if (it == mapWallet.end())
+                continue;
+            const CWalletTx* pcoin = &it->second;
+            if (!CheckFinalTx(*pcoin->tx))
+                continue;
+            vCoins.push_back(COutput(pcoin, outpoint.n, nDepth, true, true, pcoin->IsTrusted()));
         }
         random_shuffle(vCoins.begin(), vCoins.end(), GetRandInt);
     }
@@ -4141,6 +4267,7 @@ CWallet* CWallet::CreateWalletFromFile(const std::string walletFile)
         }
     }
     walletInstance->SetBroadcastTransactions(gArgs.GetBoolArg("-walletbroadcast", DEFAULT_WALLETBROADCAST));
+    walletInstance->LoadStakeCandidates();
 
     {
         LOCK(walletInstance->cs_wallet);
@@ -4352,48 +4479,19 @@ CTxDestination CWallet::AddAndGetDestinationForScript(const CScript& script, Out
 
 uint64_t CWallet::GetStakeWeight() const
 {
-    // Choose coins to use
-    const Consensus::Params& params = Params().GetConsensus();
-    CAmount nBalance = GetBalance();
     CAmount nReserveBalance = 0;
     if (gArgs.IsArgSet("-reservebalance") && !ParseMoney(gArgs.GetArg("-reservebalance", ""), nReserveBalance))
         return error("CreateCoinStake : invalid reserve balance amount");
 
-    if (nBalance <= nReserveBalance)
-        return 0;
-
-    std::vector<const CWalletTx*> vwtxPrev;
-
-    std::set<std::pair<const CWalletTx*,unsigned int> > setCoins;
-    int64_t nValueIn = 0;
-
-    if (!SelectCoinsForStaking(GetTime(), nBalance - nReserveBalance, setCoins, nValueIn))
-        return 0;
-
-    if (setCoins.empty())
-        return 0;
-
-    uint64_t nWeight = 0;
     LOCK2(cs_main, cs_wallet);
-
-    std::set<std::pair<const CWalletTx*,unsigned int> >::iterator it = setCoins.begin();
-    for (; it != setCoins.end(); ++it) {
-        auto pcoin = *it;
-        if (IsReductionActive(chainActive.Tip(), Params().GetConsensus())) {
-            if (pcoin.first->GetDepthInMainChain() >= params.nStakeMinConfirmations_Reduction)
-                nWeight += pcoin.first->tx->vout[pcoin.second].nValue;
-        }
-        else if (pcoin.first->GetDepthInMainChain() >= params.nStakeMinConfirmations)
-            nWeight += pcoin.first->tx->vout[pcoin.second].nValue;
-    }
-
-    return nWeight;
+    CAmount nWeight = GetStakeableValue() - nReserveBalance;
+    return nWeight > 0 ? nWeight : 0;
 }
 
 
 // pulsar: create coin stake transaction
 typedef std::vector<unsigned char> valtype;
-bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, CMutableTransaction& txNew)
+bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, int64_t nSearchInterval, CMutableTransaction& txNew)
 {
     CBlockIndex* pindexPrev = chainActive.Tip();
     
@@ -4440,8 +4538,10 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, CMu
     std::vector<std::pair<const CWalletTx*,unsigned int> > sortedCoins;
     std::vector<const CWalletTx*> vwtxPrev;
     CAmount nValueIn = 0;
-    // Select coins with suitable depth
-    if (!SelectCoinsForStaking(txNew.nTime, nBalance - nReserveBalance, setCoins, nValueIn))
+    // Kernel search covers the nSearchInterval seconds up to txNew.nTime
+    unsigned int nSearchFrom = txNew.nTime - std::max<int64_t>(std::min<int64_t>(nSearchInterval, txNew.nTime), 1) + 1;
+    // Select coins with suitable depth, older than any timestamp searched
+    if (!SelectCoinsForStaking(nSearchFrom, nBalance - nReserveBalance, setCoins, nValueIn))
         return false;
     if (setCoins.empty()) {
         LogPrint(BCLog::ALERT, "-- CreateCoinStake: Have no coin to stake\n");
@@ -4453,90 +4553,81 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, CMu
     std::sort(sortedCoins.begin(), sortedCoins.end(), compareCWalletTx);
     CAmount nCredit = 0;
     CScript scriptPubKeyKernel;
+    std::vector<std::pair<const CWalletTx*,unsigned int> > vKernelCoins;
+    std::vector<CStakeCandidate> vKernelCandidates;
+    std::vector<CStakeKernelInput> vKernelInputs;
     for (const auto &pcoin : sortedCoins) {
-        CDiskTxPos postx;
-        if (!pblocktree->ReadTxIndex(pcoin.first->GetHash(), postx))
+        CStakeCandidate candidate;
+        if (!GetStakeCandidate(*pcoin.first, pcoin.second, candidate))
             continue;
 
-        // Read block header
-        CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-        CBlockHeader header;
-        CTransactionRef tx;
-        try {
-            file >> header;
-            fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-            file >> tx;
-        } catch (std::exception &e) {
-            return error("%s() : deserialize or I/O error in CreateCoinStake()", __PRETTY_FUNCTION__);
-        }
-
-        COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
-        if (CheckKernel(nBits, pindexPrev, header, tx, prevoutStake, txNew.nTime)) {
-            // Found a kernel
+        CStakeKernelInput input;
+        input.prevout = COutPoint(pcoin.first->GetHash(), pcoin.second);
+        input.hashBlockFrom = candidate.hashBlock;
+        input.nTimeTxPrev = candidate.nTimeTx;
+        input.nValue = candidate.nValue;
+        vKernelCoins.push_back(pcoin);
+        vKernelCandidates.push_back(candidate);
+        vKernelInputs.push_back(input);
+    }
+    // Search every timestamp of the interval at once, the earliest kernel becomes the coinstake time
+    unsigned int nTimeKernel;
+    size_t nKernel;
+    if (SearchStakeKernel(nBits, pindexPrev, vKernelInputs, nSearchFrom, txNew.nTime, nTimeKernel, nKernel)) {
+        const auto &pcoin = vKernelCoins[nKernel];
+        const CStakeCandidate &candidate = vKernelCandidates[nKernel];
+        txNew.nTime = nTimeKernel;
+        // Found a kernel
+        if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
+            LogPrintf("CreateCoinStake : kernel found\n");
+        std::vector<valtype> vSolutions;
+        txnouttype whichType;
+        CScript scriptPubKeyOut;
+        scriptPubKeyKernel = pcoin.first->tx->vout[pcoin.second].scriptPubKey;
+        if (!Solver(scriptPubKeyKernel, whichType, vSolutions))
+        {
             if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
-                LogPrintf("CreateCoinStake : kernel found\n");
-            std::vector<valtype> vSolutions;
-            txnouttype whichType;
-            CScript scriptPubKeyOut;
-            scriptPubKeyKernel = pcoin.first->tx->vout[pcoin.second].scriptPubKey;
-            if (!Solver(scriptPubKeyKernel, whichType, vSolutions))
-            {
-                if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
-                    LogPrintf("CreateCoinStake : failed to parse kernel type=%d\n", whichType);
-                break;
-            }
+                LogPrintf("CreateCoinStake : failed to parse kernel type=%d\n", whichType);
+            return false;
+        }
+        if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
+            LogPrintf("CreateCoinStake : parsed kernel type=%d\n", whichType);
+        if (whichType != TX_PUBKEY && whichType != TX_PUBKEYHASH && whichType != TX_WITNESS_V0_KEYHASH) {
             if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
-                LogPrintf("CreateCoinStake : parsed kernel type=%d\n", whichType);
-            if (whichType != TX_PUBKEY && whichType != TX_PUBKEYHASH && whichType != TX_WITNESS_V0_KEYHASH) {
+                LogPrintf("CreateCoinStake : no support for kernel type=%d\n", whichType);
+            return false;  // only support pay to public key and pay to address and pay to witness keyhash
+        }
+        if (whichType == TX_PUBKEYHASH || whichType == TX_WITNESS_V0_KEYHASH) {// pay to address type or witness keyhash
+            // convert to pay to public key type
+            CKey key;
+            if (!keystore.GetKey(CKeyID(uint160(vSolutions[0])), key))
+            {
                 if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
-                    LogPrintf("CreateCoinStake : no support for kernel type=%d\n", whichType);
-                break;  // only support pay to public key and pay to address and pay to witness keyhash
-            }
-            if (whichType == TX_PUBKEYHASH || whichType == TX_WITNESS_V0_KEYHASH) {// pay to address type or witness keyhash
-                // convert to pay to public key type
-                CKey key;
-                if (!keystore.GetKey(CKeyID(uint160(vSolutions[0])), key))
-                {
-                    if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
-                        LogPrintf("CreateCoinStake : failed to get key for kernel type=%d\n", whichType);
-                    break;  // unable to find corresponding public key
-                }
-                scriptPubKeyOut << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+                    LogPrintf("CreateCoinStake : failed to get key for kernel type=%d\n", whichType);
+                return false;  // unable to find corresponding public key
             }
-            else {
-                scriptPubKeyOut = scriptPubKeyKernel;
-            }
-            txNew.vin.push_back(CTxIn(pcoin.first->GetHash(), pcoin.second));
-            nCredit += pcoin.first->tx->vout[pcoin.second].nValue;
-            vwtxPrev.push_back(pcoin.first);
-            txNew.vout.push_back(CTxOut(0, scriptPubKeyOut));
-            if (header.GetBlockTime() + nStakeSplitAge > txNew.nTime)
-                txNew.vout.push_back(CTxOut(0, scriptPubKeyOut)); //split stake
-            if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
-                LogPrintf("CreateCoinStake : added kernel type=%d\n", whichType);
-            break;
+            scriptPubKeyOut << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
         }
+        else {
+            scriptPubKeyOut = scriptPubKeyKernel;
+        }
+        txNew.vin.push_back(CTxIn(pcoin.first->GetHash(), pcoin.second));
+        nCredit += pcoin.first->tx->vout[pcoin.second].nValue;
+        vwtxPrev.push_back(pcoin.first);
+        txNew.vout.push_back(CTxOut(0, scriptPubKeyOut));
+        if (candidate.nTimeBlock + nStakeSplitAge > txNew.nTime)
+            txNew.vout.push_back(CTxOut(0, scriptPubKeyOut)); //split stake
+        if (gArgs.GetBoolArg("-debug", false) && gArgs.GetBoolArg("-printcoinstake", false))
+            LogPrintf("CreateCoinStake : added kernel type=%d\n", whichType);
     }
     if (nCredit == 0 || nCredit > nBalance - nReserveBalance) {
         return false;
     }
 
     for (const auto &pcoin : sortedCoins) {
-        CDiskTxPos postx;
-        if (!pblocktree->ReadTxIndex(pcoin.first->GetHash(), postx))
+        CStakeCandidate candidate;
+        if (!GetStakeCandidate(*pcoin.first, pcoin.second, candidate))
             continue;
-
-        // Read block header
-        CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-        CBlockHeader header;
-        CTransactionRef tx;
-        try {
-            file >> header;
-            fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-            file >> tx;
-        } catch (std::exception &e) {
-            return error("%s() : deserialize or I/O error in CreateCoinStake()", __PRETTY_FUNCTION__);
-        }
         CScript scriptPubKey = pcoin.first->tx->vout[pcoin.second].scriptPubKey;
 
         // Attempt to add more inputs
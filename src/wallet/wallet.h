@@ -531,7 +531,23 @@ public:
     std::string ToString() const;
 };
 
+/** What the stake kernel search needs to know about one of our confirmed outputs */
+class CStakeCandidate
+{
+public:
+    CAmount nValue;
+    //! nTime of the transaction holding the output
+    unsigned int nTimeTx;
+    //! Block holding that transaction
+    uint256 hashBlock;
+    int nHeight;
+    unsigned int nTimeBlock;
+    //! Coinbase or coinstake output, which has to reach coinbase maturity too
+    bool fGenerated;
 
+    CStakeCandidate() : nValue(0), nTimeTx(0), nHeight(0), nTimeBlock(0), fGenerated(false) {}
+    CStakeCandidate(CAmount nValueIn, unsigned int nTimeTxIn, const CBlockIndex* pindex, bool fGeneratedIn);
+};
 
 
 /** Private key that includes an expiration date in case it never gets used. */
@@ -698,6 +714,28 @@ private:
      * Should be called with pindexBlock and posInBlock if this is for a transaction that is included in a block. */
     void SyncTransaction(const CTransactionRef& tx, const CBlockIndex *pindex = nullptr, int posInBlock = 0);
 
+    /**
+     * Our confirmed, unspent and spendable outputs by outpoint, which are the
+     * stake kernel candidates. Filled when the wallet is loaded and kept up to
+     * date as transactions are added, confirmed, disconnected, abandoned or
+     * conflicted, so neither staking nor the stake weight scan mapWallet or
+     * read the block files.
+     */
+    std::map<COutPoint, CStakeCandidate> mapStakeCandidates;
+    //! Total value of mapStakeCandidates, and its value by confirmation height for
+    //! ordinary [0] and generated [1] outputs, to tell the mature part from the tip height
+    CAmount nStakeCandidatesValue = 0;
+    std::map<int, CAmount> mapStakeValueByHeight[2];
+
+    void AddStakeCandidate(const COutPoint& outpoint, const CStakeCandidate& candidate);
+    void EraseStakeCandidate(const COutPoint& outpoint);
+    /* Add the unspent outputs of tx that we can spend as stake candidates, tx being included in the block pindex */
+    void AddStakeCandidates(const CTransaction& tx, const CBlockIndex* pindex);
+    /* Add outpoint back as a stake candidate if it is no longer spent, after its spending transaction was disconnected, abandoned or conflicted */
+    void RestoreStakeCandidate(const COutPoint& outpoint);
+    /* Look up the stake candidate for output n of wtx, building it if missing. Returns false if wtx is not in the main chain. */
+    bool GetStakeCandidate(const CWalletTx& wtx, unsigned int n, CStakeCandidate& candidate);
+
     /* the HD chain data model (external chain counters) */
     CHDChain hdChain;
 
@@ -971,7 +1009,14 @@ public:
     bool CreateTransaction(const std::vector<CRecipient>& vecSend, CWalletTx& wtxNew, CReserveKey& reservekey, CAmount& nFeeRet, int& nChangePosInOut,
                            std::string& strFailReason, const CCoinControl& coin_control, bool sign = true);
     uint64_t GetStakeWeight() const;
-    bool CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, CMutableTransaction &txNew);
+    /* Value of the stake candidates that are deep enough to stake at the current tip */
+    CAmount GetStakeableValue() const;
+    /* Build the stake candidates from mapWallet, after loading */
+    void LoadStakeCandidates();
+    const std::map<COutPoint, CStakeCandidate>& GetStakeCandidates() const { AssertLockHeld(cs_wallet); return mapStakeCandidates; }
+    CAmount GetStakeCandidatesValue() const { AssertLockHeld(cs_wallet); return nStakeCandidatesValue; }
+    const std::map<int, CAmount>& GetStakeValueByHeight(bool fGenerated) const { AssertLockHeld(cs_wallet); return mapStakeValueByHeight[fGenerated]; }
+    bool CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, int64_t nSearchInterval, CMutableTransaction &txNew);
     bool CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey, CConnman* connman, CValidationState& state);
 
     void ListAccountCreditDebit(const std::string& strAccount, std::list<CAccountingEntry>& entries);
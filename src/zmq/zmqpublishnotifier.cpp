@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <networkstats.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -16,6 +17,7 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_NETWORKSTATS = "networkstats";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -195,3 +197,14 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishNetworkStatsNotifier::NotifyBlock(const CBlockIndex *pindex)
+{
+    if (!g_networkstats)
+        return true;
+    LogPrint(BCLog::ZMQ, "zmq: Publish networkstats %s\n", pindex->GetBlockHash().GetHex());
+    // The estimator is registered before the notifiers, so it already follows
+    // the new tip. Publishing only reads its estimates.
+    std::string strStats = NetworkStatsToJSON(g_networkstats->GetStats()).write();
+    return SendMessage(MSG_NETWORKSTATS, strStats.data(), strStats.size());
+}